@@ -2,6 +2,8 @@
 
 #include <Game/Core.hpp>
 
+#include "tick.hpp"
+
 namespace as {
 class essence_pouch {
 public:
@@ -88,8 +90,8 @@ public:
     if (!pouch.Interact("Fill"))
       return false;
 
-    if (!WaitFunc(2000, 50,
-                  [&]() { return Inventory::Count(essence_name) < count; }))
+    if (!tick::wait(2000,
+                    [&]() { return Inventory::Count(essence_name) < count; }))
       return false;
 
     _current_count +=
@@ -120,8 +122,8 @@ public:
     }
     Interact::UpKey(Key::KEY_SHIFT);
 
-    if (!WaitFunc(2000, 50,
-                  [&]() { return Inventory::CountEmpty() < empty_slots; }))
+    if (!tick::wait(2000,
+                    [&]() { return Inventory::CountEmpty() < empty_slots; }))
       return false;
 
     if (empty_slots < _current_count) {
@@ -9,6 +9,7 @@
 #include <nlohmann/json.hpp>
 
 #include "mouse_camera.hpp"
+#include "tick.hpp"
 
 namespace as::exchange {
 
@@ -190,7 +191,7 @@ bool open() {
   if (!npc.Interact("Exchange Grand Exchange Clerk"))
     return false;
 
-  return WaitFunc(2500, 50, is_open);
+  return tick::wait(2500, is_open);
 }
 
 bool close() {
@@ -204,7 +205,7 @@ bool close() {
   if (!widget.Interact("Close"))
     return false;
 
-  return WaitFunc(2500, 50, [] { return !is_open(); });
+  return tick::wait(2500, [] { return !is_open(); });
 }
 
 bool in_slot_selection() {
@@ -299,8 +300,8 @@ bool collect_to_inventory() {
   if (!widget.Interact("Collect to inventory"))
     return false;
 
-  if (!WaitFunc(2000, 50,
-                []() { return !detail::collect_all_button().IsVisible(); }))
+  if (!tick::wait(2000,
+                  []() { return !detail::collect_all_button().IsVisible(); }))
     return false;
 
   Wait(2500); // Slot widgets take forever to update after collecting
@@ -318,8 +319,8 @@ bool collect_to_bank() {
   if (!widget.Interact("Collect to bank"))
     return false;
 
-  if (!WaitFunc(2000, 50,
-                []() { return !detail::collect_all_button().IsVisible(); }))
+  if (!tick::wait(2000,
+                  []() { return !detail::collect_all_button().IsVisible(); }))
     return false;
 
   Wait(2500); // Slot widgets take forever to update after collecting
@@ -342,7 +343,8 @@ bool set_buy_offer_name(const std::string &name) {
 
   Interactable::Widget first_result;
 
-  if (!WaitFunc(2000, 50, [&]() {
+  // the search results are filled in by the client as the name is typed
+  if (!tick::wait_client(2000, [&]() {
         first_result = detail::get_buy_offer_first_search_result();
         auto first_result_name =
             detail::get_buy_offer_search_result_name(first_result);
@@ -355,7 +357,7 @@ bool set_buy_offer_name(const std::string &name) {
   if (!first_result.Interact())
     return false;
 
-  return WaitFunc(2000, 50, [&]() { return detail::get_offer_name() == name; });
+  return tick::wait(2000, [&]() { return detail::get_offer_name() == name; });
 }
 
 bool set_sell_offer_item(const std::int32_t id) {
@@ -376,7 +378,7 @@ bool set_sell_offer_item(const std::int32_t id) {
   if (!item.Interact("Offer"))
     return false;
 
-  return WaitFunc(2000, 50, [&]() { return detail::get_offer_name() == name; });
+  return tick::wait(2000, [&]() { return detail::get_offer_name() == name; });
 }
 
 bool set_offer_quantity(std::int32_t amount) {
@@ -391,7 +393,7 @@ bool set_offer_quantity(std::int32_t amount) {
   if (!widget.Interact())
     return false;
 
-  if (!WaitFunc(2000, 50, []() {
+  if (!tick::wait(2000, []() {
         return Chat::GetDialogueState() == Chat::ENTER_AMOUNT;
       }))
     return false;
@@ -399,8 +401,8 @@ bool set_offer_quantity(std::int32_t amount) {
   if (!Chat::EnterAmount(amount))
     return false;
 
-  return WaitFunc(2000, 50,
-                  [&]() { return detail::get_offer_quantity() == amount; });
+  return tick::wait(2000,
+                    [&]() { return detail::get_offer_quantity() == amount; });
 }
 
 bool set_offer_price_per_item(std::int32_t price) {
@@ -412,7 +414,7 @@ bool set_offer_price_per_item(std::int32_t price) {
   if (!widget.Interact())
     return false;
 
-  if (!WaitFunc(2000, 50, []() {
+  if (!tick::wait(2000, []() {
         return Chat::GetDialogueState() == Chat::ENTER_AMOUNT;
       }))
     return false;
@@ -449,7 +451,7 @@ bool confirm_offer() {
   if (!widget.Interact())
     return false;
 
-  return WaitFunc(2000, 50, in_slot_selection);
+  return tick::wait(2000, in_slot_selection);
 }
 
 bool backout_offer() {
@@ -461,7 +463,7 @@ bool backout_offer() {
   if (!widget.Interact())
     return false;
 
-  return WaitFunc(2000, 50, [&]() { return in_slot_selection(); });
+  return tick::wait(2000, [&]() { return in_slot_selection(); });
 }
 
 bool open_buy_offer(slot s) {
@@ -475,7 +477,7 @@ bool open_buy_offer(slot s) {
   if (!widget.Interact())
     return false;
 
-  return WaitFunc(2000, 50, []() {
+  return tick::wait(2000, []() {
     return Chat::GetDialogueState() == Chat::ENTER_AMOUNT &&
            is_buy_offer_open();
   });
@@ -492,7 +494,7 @@ bool open_sell_offer(slot s) {
   if (!widget.Interact())
     return false;
 
-  return WaitFunc(2000, 50, is_sell_offer_open);
+  return tick::wait(2000, is_sell_offer_open);
 }
 
 bool create_buy_offer(slot s, const order &o) {
@@ -6,6 +6,8 @@
 #include <utility>
 #include <vector>
 
+#include "tick.hpp"
+
 namespace as {
 
 template <typename Identifier>
@@ -69,7 +71,7 @@ public:
     if (!item.Interact(action))
       return equip();
 
-    return WaitFunc(1250, 50, [&]() { return equipped(); });
+    return tick::wait(1250, [&]() { return equipped(); });
   }
 };
 
@@ -13,7 +13,7 @@ public:
     const auto pos = Minimap::GetPosition();
 
     if (!ge.in_area(pos)) {
-      const auto path = as::web_walker::find_path(pos, ge.location);
+      const auto path = as::web_walker::find_path(pos, ge.area);
       if (!as::web_walker::walk_path(path, 6))
         return;
     }
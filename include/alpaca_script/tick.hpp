@@ -0,0 +1,180 @@
+#pragma once
+
+#include <Game/Core.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace as::tick {
+using clock_type = std::chrono::steady_clock;
+
+// length of a game tick
+constexpr std::chrono::milliseconds length{600};
+
+// once the phase is known, polls this far either side of a predicted tick
+constexpr std::chrono::milliseconds window{25};
+
+// poll interval inside the window
+constexpr std::chrono::milliseconds fine_interval{10};
+
+// poll interval while the phase is unknown, the interval of the WaitFunc
+// polling this replaces
+constexpr std::chrono::milliseconds learn_interval{50};
+
+// widest gap between two player samples a change between them teaches the
+// phase from
+constexpr std::chrono::milliseconds observe_gap =
+    learn_interval + fine_interval;
+
+// poll interval for state the client changes on its own, one client frame
+constexpr std::chrono::milliseconds frame{20};
+
+// changes caught out of the window before the phase is learnt again
+constexpr std::int32_t max_misses = 3;
+
+// Phase of the game tick as the client sees it, learnt from changes of the
+// shared player sample caught between two samples close together.
+class phase_estimate {
+public:
+  bool known() const { return _known; }
+
+  // a state change happened after before and no later than after
+  void observe(clock_type::time_point before, clock_type::time_point after) {
+    if (after - before > observe_gap)
+      return;
+
+    const auto tick = before + (after - before) / 2;
+    _misses = 0;
+    if (!_known) {
+      _anchor = tick;
+      _known = true;
+      return;
+    }
+
+    auto error = (tick - _anchor) % length;
+    if (error > length / 2)
+      error -= length;
+    else if (error < -length / 2)
+      error += length;
+
+    _anchor += error / 4;
+  }
+
+  // a state change was caught out of the window, the phase may be off
+  void miss() {
+    if (_known && ++_misses >= max_misses)
+      _known = false;
+  }
+
+  // first predicted tick at or after the given time
+  clock_type::time_point next(clock_type::time_point after) const {
+    auto since = (after - _anchor) % length;
+    if (since < clock_type::duration::zero())
+      since += length;
+
+    return since == clock_type::duration::zero() ? after
+                                                 : after + (length - since);
+  }
+
+private:
+  clock_type::time_point _anchor;
+  bool _known = false;
+  std::int32_t _misses = 0;
+};
+
+phase_estimate phase;
+
+// State of the local player, read at most once per poll and shared by every
+// waiter. The player only changes on a tick, so changes between two close
+// samples teach the tick phase, and a change the phase did not expect between
+// two samples further apart counts as a miss. Nothing else does: predicates
+// may watch state the client changes between ticks.
+class player_state {
+public:
+  Tile position;
+  bool moving = false;
+  bool animating = false;
+  clock_type::time_point time;
+};
+
+const player_state &player() {
+  static player_state state;
+
+  const auto now = clock_type::now();
+  if (state.time != clock_type::time_point() &&
+      now - state.time < fine_interval)
+    return state;
+
+  const auto position = Minimap::GetPosition();
+  const auto moving = Mainscreen::IsMoving();
+  const auto animating = Mainscreen::IsAnimating();
+  if (state.time != clock_type::time_point() &&
+      (position != state.position || moving != state.moving ||
+       animating != state.animating)) {
+    if (now - state.time <= observe_gap)
+      phase.observe(state.time, now);
+    else if (phase.known() && phase.next(state.time - window) > now)
+      phase.miss();
+  }
+
+  state = player_state{position, moving, animating, now};
+  return state;
+}
+
+namespace detail {
+clock_type::time_point next_poll(clock_type::time_point now) {
+  if (!phase.known())
+    return now + learn_interval;
+
+  const auto tick = phase.next(now - window);
+  if (now >= tick - window)
+    return now + fine_interval;
+
+  // sleep until the window opens, with one poll mid tick in case the phase
+  // is off
+  return std::min(tick - window, now + length / 2);
+}
+
+void sleep_until(clock_type::time_point until) {
+  const auto now = clock_type::now();
+  if (until <= now)
+    return;
+
+  Wait(static_cast<std::uint32_t>(
+      std::chrono::ceil<std::chrono::milliseconds>(until - now).count()));
+}
+} // namespace detail
+
+// Waits up to timeout ms for a predicate on game state. Game state only
+// changes on a tick, so the predicate is polled densely around the predicted
+// ticks and left alone in between, and the wait returns within a poll of the
+// change. Every poll also takes the shared player sample, which is what keeps
+// the phase learnt.
+bool wait(std::uint32_t timeout, const std::function<bool()> &predicate) {
+  if (predicate())
+    return true;
+
+  const auto deadline =
+      clock_type::now() + std::chrono::milliseconds(timeout);
+
+  for (auto last = clock_type::now(); last < deadline;) {
+    detail::sleep_until(std::min(detail::next_poll(last), deadline));
+
+    player();
+    if (predicate())
+      return true;
+
+    last = clock_type::now();
+  }
+
+  return false;
+}
+
+// Waits up to timeout ms for a predicate on state the client changes between
+// ticks, like a search typed into an interface.
+bool wait_client(std::uint32_t timeout,
+                 const std::function<bool()> &predicate) {
+  return WaitFunc(timeout, frame.count(), predicate);
+}
+} // namespace as::tick
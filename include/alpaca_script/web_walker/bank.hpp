@@ -3,6 +3,7 @@
 #include <Game/Core.hpp>
 
 #include <alpaca_script/mouse_camera.hpp>
+#include <alpaca_script/tick.hpp>
 
 namespace as::web_walker {
 class bank {
@@ -66,7 +67,7 @@ public:
     if (!obj.Interact("Bank"))
       return false;
 
-    return WaitFunc(2500, 50, Bank::IsOpen);
+    return tick::wait(2500, Bank::IsOpen);
   }
 };
 } // namespace as::web_walker
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bank.hpp"
+#include "bucket_queue.hpp"
+#include "collision.hpp"
+#include "line_of_sight.hpp"
+#include "obstacles.hpp"
+#include "path_finder_settings.hpp"
+#include "tile_key.hpp"
+
+namespace as::web_walker {
+// Travel cost from every tile near a bank to the closest bank, found with one
+// reverse breadth first search seeded from the walkable tiles of every bank
+// area. The field goes stale once the collision data or the obstacles change,
+// which is_current tells, and banks::get_closest then builds it again. Changes
+// to the set of accessible banks are not noticed, the owner builds it again.
+class bank_distances {
+public:
+  using bank_list = std::vector<std::reference_wrapper<const bank>>;
+
+  // tiles further than this from every bank are left out of the field
+  static constexpr std::int32_t max_distance = 256;
+
+  // the search stops once the field holds this many tiles, the ones left out
+  // are further from every bank than all of them
+  static constexpr std::size_t max_tiles = std::size_t(1) << 18;
+
+  // walkable tiles this close to the bank location seed the search, if they
+  // are in the bank area
+  static constexpr std::int32_t seed_radius = 4;
+
+  class entry {
+  public:
+    std::int32_t distance;
+    std::uint32_t bank; // index into the bank list
+  };
+
+  std::optional<entry> find(const Tile &tile) const {
+    auto it = _field.find(tile);
+    if (it == _field.end())
+      return std::nullopt;
+
+    return it->second;
+  }
+
+  // built, and for the collision data and obstacles loaded now
+  bool is_current() const {
+    return _built && _collision_version == collision_version &&
+           _obstacle_version == obstacle_version;
+  }
+
+  bool is_current(const path_finder_settings &settings) const {
+    return is_current() && _settings_hash == settings.hash();
+  }
+
+  void build(const bank_list &banks, const path_finder_settings &settings) {
+    _field.clear();
+    _built = true;
+    _collision_version = collision_version;
+    _obstacle_version = obstacle_version;
+    _settings_hash = settings.hash();
+
+    const auto sources = _reverse_obstacles(settings);
+
+    bucket_queue<std::uint32_t> queue;
+
+    const auto relax = [&](const tile_key &key, std::int32_t distance,
+                           std::uint32_t bank) {
+      if (distance > max_distance || _field.size() >= max_tiles)
+        return;
+
+      auto [it, inserted] = _field.try_emplace(key, entry{distance, bank});
+      if (!inserted) {
+        if (it->second.distance <= distance)
+          return;
+
+        it->second = entry{distance, bank};
+      }
+
+      queue.push(distance, key.value);
+    };
+
+    for (std::uint32_t i = 0; i < banks.size(); ++i) {
+      const auto &b = banks[i].get();
+      if (!b.accessible())
+        continue;
+
+      for (auto dx = -seed_radius; dx <= seed_radius; ++dx) {
+        for (auto dy = -seed_radius; dy <= seed_radius; ++dy) {
+          const auto tile = b.location + Tile(dx, dy, 0);
+          if (b.in_area(tile) && is_mapped(tile) &&
+              !blocked(is_collision(tile)))
+            relax(tile, 0, i);
+        }
+      }
+    }
+
+    constexpr std::int32_t directions[4][2] = {
+        {0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+
+    while (!queue.empty()) {
+      const auto [key_distance, value] = queue.pop();
+      const auto distance = static_cast<std::int32_t>(key_distance);
+
+      const auto key = tile_key(value);
+      const auto current = _field.at(key);
+      if (current.distance != distance)
+        continue;
+
+      const auto tile = key.to_tile();
+
+      // forward, a tile with obstacles can only be entered through them
+      auto edges = obstacle_map.edges(tile);
+      if (edges.first == edges.second) {
+        for (const auto &[dx, dy] : directions) {
+          const auto from = tile + Tile(dx, dy, 0);
+          if (is_mapped(from) && can_step(from, -dx, -dy))
+            relax(from, distance + 1, current.bank);
+        }
+      }
+
+      auto [first, last] = sources.equal_range(key);
+      for (auto it = first; it != last; ++it)
+        relax(it->second, distance + 1, current.bank);
+    }
+  }
+
+  void clear() {
+    _field.clear();
+    _built = false;
+  }
+
+  std::size_t size() const { return _field.size(); }
+
+private:
+  std::unordered_map<tile_key, entry> _field;
+
+  bool _built = false;
+  std::uint64_t _collision_version = 0;
+  std::uint64_t _obstacle_version = 0;
+  std::uint64_t _settings_hash = 0;
+
+  // For every obstacle destination, the tiles the obstacle is taken from.
+  // These are the same steps visit_neighbors produces, and cost one like
+  // walking a tile.
+  static std::unordered_multimap<tile_key, tile_key>
+  _reverse_obstacles(const path_finder_settings &settings) {
+    std::unordered_multimap<tile_key, tile_key> result;
+
+    const std::pair<Tile, std::int32_t> approaches[4] = {
+        {Tile(0, -1, 0), Pathfinding::NORTH},
+        {Tile(-1, 0, 0), Pathfinding::EAST},
+        {Tile(0, 1, 0), Pathfinding::SOUTH},
+        {Tile(1, 0, 0), Pathfinding::WEST}};
+
+    for (auto it = obstacle_map.begin(); it != obstacle_map.end();) {
+      const auto key = it->first;
+      const auto tile = key.to_tile();
+
+      auto [first, last] = obstacle_map.edges(key);
+      for (auto edge = first; edge != last; ++edge) {
+        if (!edge->can_handle(settings))
+          continue;
+
+        for (const auto &[offset, flag] : approaches) {
+          const auto from = tile + offset;
+          if (is_mapped(from) && !(is_collision(from) & flag))
+            result.emplace(edge->destination, tile_key(from));
+        }
+      }
+
+      it += last - first;
+    }
+
+    return result;
+  }
+};
+} // namespace as::web_walker
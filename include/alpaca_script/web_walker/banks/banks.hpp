@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../bank.hpp"
+#include "../bank_distances.hpp"
+#include "../path_finder_settings.hpp"
 #include "fossil_island_bank.hpp"
 #include "grand_exchange.hpp"
 #include "lunar_isle.hpp"
@@ -28,11 +30,22 @@ const std::vector<std::reference_wrapper<const bank>> &all() {
   static std::vector<std::reference_wrapper<const bank>> banks = {
       std::cref(lumbridge_bank),    std::cref(varrock_east_bank),
       std::cref(varrock_west_bank), std::cref(grand_exchange),
-      std::cref(edgeville_bank),    std::cref(lunar_island)};
+      std::cref(edgeville_bank),    std::cref(lunar_island),
+      std::cref(fossil_island)};
   return banks;
 }
 
-const bank &get_closest(const Tile &tile) {
+bank_distances distances;
+
+// Builds the travel cost field get_closest answers from. get_closest builds it
+// on first use and again once the collision data or the obstacles change;
+// call it when the settings or the accessible banks change.
+void build_distances(const path_finder_settings &settings) {
+  distances.build(all(), settings);
+}
+
+namespace detail {
+const bank &closest_in_line(const Tile &tile) {
   const auto &banks = all();
 
   auto closest = banks.begin();
@@ -46,4 +59,31 @@ const bank &get_closest(const Tile &tile) {
   }
   return *closest;
 }
+} // namespace detail
+
+// Bank with the lowest travel cost from tile. The field is built with the
+// player's settings when there is none for the loaded collision data and
+// obstacles, a field built with other settings is kept. Outside the field,
+// the bank closest in a straight line.
+const bank &get_closest(const Tile &tile) {
+  if (!distances.is_current())
+    build_distances(get_player_settings());
+
+  if (auto nearest = distances.find(tile))
+    return all()[nearest->bank];
+
+  return detail::closest_in_line(tile);
+}
+
+// Same, but from a field built with the given settings.
+const bank &get_closest(const Tile &tile,
+                        const path_finder_settings &settings) {
+  if (!distances.is_current(settings))
+    build_distances(settings);
+
+  if (auto nearest = distances.find(tile))
+    return all()[nearest->bank];
+
+  return detail::closest_in_line(tile);
+}
 } // namespace as::web_walker::banks
@@ -25,7 +25,7 @@ public:
     if (!chest.Interact("Use"))
       return false;
     
-    return WaitFunc(2500, 50, Bank::IsOpen);
+    return tick::wait(2500, Bank::IsOpen);
   }
 };
 } // namespace as::web_walker::banks
\ No newline at end of file
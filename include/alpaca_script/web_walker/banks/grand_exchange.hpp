@@ -35,7 +35,7 @@ public:
     if (!obj.Interact("Exchange"))
       return false;
 
-    return WaitFunc(2500, 50, Bank::IsOpen);
+    return tick::wait(2500, Bank::IsOpen);
   }
 };
 
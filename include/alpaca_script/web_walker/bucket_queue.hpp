@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace as::web_walker {
+// Priority queue for small monotone integer keys, as used by Dijkstra's search
+// over tile costs. Buckets form a ring of at least max key spread + 1 entries,
+// values with equal keys come out in insertion order, and clear() keeps every
+// allocation so a queue can be reused across searches.
+template <typename T> class bucket_queue {
+public:
+  explicit bucket_queue(
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : _buckets(16, resource), _heads(16, 0, resource) {}
+
+  bool empty() const { return _size == 0; }
+
+  std::size_t size() const { return _size; }
+
+  // smallest key that can still be pushed
+  std::uint32_t current() const { return _current; }
+
+  void push(std::uint32_t key, T value) {
+    if (key < _current)
+      throw std::runtime_error("bucket_queue key below the current minimum");
+
+    if (key - _current >= _buckets.size())
+      _grow(key - _current + 1);
+
+    _buckets[key & _mask()].push_back(std::move(value));
+    ++_size;
+  }
+
+  std::pair<std::uint32_t, T> pop() {
+    if (empty())
+      throw std::runtime_error("bucket_queue is empty");
+
+    while (_heads[_current & _mask()] == _buckets[_current & _mask()].size())
+      ++_current;
+
+    const auto i = _current & _mask();
+    auto value = std::move(_buckets[i][_heads[i]++]);
+    if (_heads[i] == _buckets[i].size()) {
+      _buckets[i].clear();
+      _heads[i] = 0;
+    }
+
+    --_size;
+    return {_current, std::move(value)};
+  }
+
+  void clear() {
+    for (auto &bucket : _buckets)
+      bucket.clear();
+
+    std::fill(_heads.begin(), _heads.end(), 0);
+    _current = 0;
+    _size = 0;
+  }
+
+private:
+  std::pmr::vector<std::pmr::vector<T>> _buckets;
+  std::pmr::vector<std::size_t> _heads;
+  std::uint32_t _current = 0;
+  std::size_t _size = 0;
+
+  std::size_t _mask() const { return _buckets.size() - 1; }
+
+  // widens the ring to at least spread buckets, keeping every value at the
+  // same key
+  void _grow(std::size_t spread) {
+    auto capacity = _buckets.size();
+    while (capacity < spread)
+      capacity *= 2;
+
+    std::pmr::vector<std::pmr::vector<T>> buckets(capacity,
+                                                  _buckets.get_allocator());
+    for (std::size_t offset = 0; offset < _buckets.size(); ++offset) {
+      const auto key = _current + static_cast<std::uint32_t>(offset);
+      const auto i = key & _mask();
+
+      auto &bucket = buckets[key & (capacity - 1)];
+      for (auto j = _heads[i]; j < _buckets[i].size(); ++j)
+        bucket.push_back(std::move(_buckets[i][j]));
+    }
+
+    _buckets = std::move(buckets);
+    _heads.assign(capacity, 0);
+  }
+};
+} // namespace as::web_walker
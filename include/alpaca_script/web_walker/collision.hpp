@@ -1,25 +1,55 @@
 #pragma once
 
 #include <Core/Types/Tile.hpp>
+#include <Game/Tools/Pathfinding.hpp>
 #include <filesystem>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <unordered_set>
 
+#include "tile_key.hpp"
+
 template <> struct std::hash<Tile> {
   std::size_t operator()(const Tile &tile) const {
-    auto hx = std::hash<std::uint32_t>{}(tile.X);
-    auto hy = std::hash<std::uint32_t>{}(tile.Y);
-    auto hz = std::hash<std::uint32_t>{}(tile.Plane);
-
-    // return hx ^ (hy << 1) ^ (hz << 2);
-    return (hx ^ (hy << 1)) ^ hz;
+    return std::hash<as::web_walker::tile_key>{}(tile);
   }
 };
 
 namespace as::web_walker {
+namespace detail {
+// splitmix64 finalizer
+std::uint64_t mix(std::uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+} // namespace detail
+
 std::unordered_set<std::int32_t> mapped_regions;
-std::unordered_map<Tile, std::int32_t> collision_map;
+std::unordered_map<tile_key, std::int32_t> collision_map;
+
+// Changes whenever different collision data is loaded. Computed as an order
+// independent sum over the loaded tiles, so it does not depend on the order
+// the region files are read in.
+std::uint64_t collision_version = 0;
+
+bool blocked(std::int32_t flags) {
+  return (flags & Pathfinding::BLOCKED) || (flags & Pathfinding::OCCUPIED);
+}
+
+std::int32_t is_collision(const Tile &tile) {
+  auto flags = collision_map.find(tile);
+  if (flags != collision_map.end()) {
+    return flags->second;
+  }
+
+  return 0;
+}
+
+bool is_mapped(const Tile &tile) {
+  auto region = ((tile.X >> 6) << 8) | (tile.Y >> 6);
+  return mapped_regions.find(region) != mapped_regions.end();
+}
 
 void initialize(const std::filesystem::path &path_to_data) {
   if (path_to_data.empty()) {
@@ -66,6 +96,11 @@ void initialize(const std::filesystem::path &path_to_data) {
       auto plane = tile["plane"].get<std::int32_t>();
       auto flags = tile["flags"].get<std::int32_t>();
       collision_map[Tile{x, y, plane}] = flags;
+
+      const auto key = tile_key(Tile{x, y, plane}).value;
+      collision_version +=
+          detail::mix((static_cast<std::uint64_t>(key) << 32) |
+                      static_cast<std::uint32_t>(flags));
     }
   }
 }
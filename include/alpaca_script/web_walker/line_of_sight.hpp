@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdlib>
+
+#include "collision.hpp"
+#include "path.hpp"
+
+namespace as::web_walker {
+// can the player step from tile into the adjacent tile at (dx, dy)
+bool can_step(const Tile &tile, std::int32_t dx, std::int32_t dy) {
+  const auto flags = is_collision(tile);
+
+  if (dx > 0 && (flags & Pathfinding::EAST))
+    return false;
+
+  if (dx < 0 && (flags & Pathfinding::WEST))
+    return false;
+
+  if (dy > 0 && (flags & Pathfinding::NORTH))
+    return false;
+
+  if (dy < 0 && (flags & Pathfinding::SOUTH))
+    return false;
+
+  return !blocked(is_collision(tile + Tile(dx, dy, 0)));
+}
+
+// Walks the supercover line between the two tiles, checking every tile and
+// every wall the line crosses. Where the line passes exactly through a corner
+// both ways around it have to be open.
+bool in_line_of_sight(const Tile &from, const Tile &to) {
+  if (from.Plane != to.Plane)
+    return false;
+
+  if (!is_mapped(from) || !is_mapped(to))
+    return false;
+
+  const auto nx = std::abs(to.X - from.X);
+  const auto ny = std::abs(to.Y - from.Y);
+  const auto sx = to.X > from.X ? 1 : -1;
+  const auto sy = to.Y > from.Y ? 1 : -1;
+
+  auto current = from;
+  for (std::int32_t ix = 0, iy = 0; ix < nx || iy < ny;) {
+    const auto decision = (1 + 2 * ix) * ny - (1 + 2 * iy) * nx;
+
+    if (decision == 0) {
+      const auto x_first = can_step(current, sx, 0) &&
+                           can_step(current + Tile(sx, 0, 0), 0, sy);
+      const auto y_first = can_step(current, 0, sy) &&
+                           can_step(current + Tile(0, sy, 0), sx, 0);
+      if (!x_first || !y_first)
+        return false;
+
+      current = current + Tile(sx, sy, 0);
+      ++ix;
+      ++iy;
+    } else if (decision < 0) {
+      if (!can_step(current, sx, 0))
+        return false;
+
+      current = current + Tile(sx, 0, 0);
+      ++ix;
+    } else {
+      if (!can_step(current, 0, sy))
+        return false;
+
+      current = current + Tile(0, sy, 0);
+      ++iy;
+    }
+  }
+
+  return true;
+}
+
+// Furthest tile of [it, end) within the given distance that the player can
+// walk to in a straight line from tile.
+path::const_iterator furthest_in_sight(path::const_iterator it,
+                                       path::const_iterator end,
+                                       const Tile &tile,
+                                       std::int32_t distance) {
+  for (auto current = end; current != it;) {
+    --current;
+
+    auto current_tile = std::get_if<Tile>(&*current);
+    if (!current_tile || current_tile->Plane != tile.Plane)
+      continue;
+
+    if (current_tile->DistanceFrom(tile) >= distance)
+      continue;
+
+    if (in_line_of_sight(tile, *current_tile))
+      return current;
+  }
+
+  return end;
+}
+} // namespace as::web_walker
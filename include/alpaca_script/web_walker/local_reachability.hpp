@@ -0,0 +1,211 @@
+#pragma once
+
+#include <Core/Types/Tile.hpp>
+#include <Game/Tools/Pathfinding.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+#include "collision.hpp"
+#include "tile_key.hpp"
+
+namespace as::web_walker {
+// Tiles walkable from a tile according to our static collision data, found
+// with one breadth first search bounded to a square around the tile. The
+// search knows nothing of obstacle_map or of live object state: a door the
+// collision data has open may be closed in game, and a tile behind a closed
+// one may be reached around it. Only flags put into the overlay, like the
+// closed walls walk_path finds when the player stalls, are added on top.
+// walk_path asks this instead of the client's Pathfinding::FindNodePathTo, so
+// it trusts the collision data until a stall proves it wrong.
+//
+// The result is kept until the origin moves, the collision data changes or
+// the overlay changes, so every candidate of a walking leg is answered by the
+// same search.
+class local_reachability {
+public:
+  // tiles further than this from the player on either axis are never
+  // reachable
+  static constexpr std::int32_t radius = 32;
+
+  static constexpr std::int32_t side = 2 * radius + 1;
+
+  static constexpr std::uint16_t unreached = 0xffff;
+
+  local_reachability()
+      : _distances(side * side, unreached), _stamps(side * side, 0) {}
+
+  // Adds collision flags on top of the collision data, for dynamic objects
+  // like closed doors or other players. Returns the flags that were not in
+  // the overlay yet, the ones to remove again when done.
+  std::int32_t add(const Tile &tile, std::int32_t flags) {
+    auto &current = _overlay[tile];
+    const auto added = flags & ~current;
+    if (added == 0)
+      return 0;
+
+    current |= added;
+    ++_overlay_version;
+    return added;
+  }
+
+  // removes the given flags from the overlay of the tile
+  void remove(const Tile &tile, std::int32_t flags) {
+    auto it = _overlay.find(tile);
+    if (it == _overlay.end() || (it->second & flags) == 0)
+      return;
+
+    it->second &= ~flags;
+    if (it->second == 0)
+      _overlay.erase(it);
+
+    ++_overlay_version;
+  }
+
+  // removes every overlay flag of the tile
+  void remove(const Tile &tile) {
+    if (_overlay.erase(tile))
+      ++_overlay_version;
+  }
+
+  void clear_overlay() {
+    if (_overlay.empty())
+      return;
+
+    _overlay.clear();
+    ++_overlay_version;
+  }
+
+  std::int32_t flags(const Tile &tile) const {
+    auto flags = is_collision(tile);
+    if (!_overlay.empty()) {
+      auto it = _overlay.find(tile);
+      if (it != _overlay.end())
+        flags |= it->second;
+    }
+
+    return flags;
+  }
+
+  bool reachable(const Tile &from, const Tile &to) {
+    return distance(from, to) != unreached;
+  }
+
+  // steps walked from from to to, or unreached
+  std::uint16_t distance(const Tile &from, const Tile &to) {
+    if (from.Plane != to.Plane || std::abs(to.X - from.X) > radius ||
+        std::abs(to.Y - from.Y) > radius)
+      return unreached;
+
+    _flood(from);
+
+    const auto i = _index(to);
+    return _stamps[i] == _stamp ? _distances[i] : unreached;
+  }
+
+  // forgets the cached search
+  void reset() { _valid = false; }
+
+  // instance of the calling thread, for path searches that must not share the
+  // walker's cache and overlay
+  static local_reachability &local() {
+    thread_local local_reachability instance;
+    return instance;
+  }
+
+private:
+  std::vector<std::uint16_t> _distances;
+  std::vector<std::uint32_t> _stamps;
+  std::vector<std::uint32_t> _queue;
+  std::uint32_t _stamp = 0;
+
+  std::unordered_map<tile_key, std::int32_t> _overlay;
+  std::uint64_t _overlay_version = 0;
+
+  bool _valid = false;
+  Tile _origin;
+  std::uint64_t _collision_version = 0;
+  std::uint64_t _searched_overlay_version = 0;
+
+  std::uint32_t _index(const Tile &tile) const {
+    return static_cast<std::uint32_t>((tile.X - _origin.X + radius) * side +
+                                      (tile.Y - _origin.Y + radius));
+  }
+
+  bool _can_step(const Tile &tile, std::int32_t dx, std::int32_t dy) const {
+    const auto flags = this->flags(tile);
+
+    if (dx > 0 && (flags & Pathfinding::EAST))
+      return false;
+
+    if (dx < 0 && (flags & Pathfinding::WEST))
+      return false;
+
+    if (dy > 0 && (flags & Pathfinding::NORTH))
+      return false;
+
+    if (dy < 0 && (flags & Pathfinding::SOUTH))
+      return false;
+
+    const auto next = tile + Tile(dx, dy, 0);
+    return is_mapped(next) && !blocked(this->flags(next));
+  }
+
+  void _flood(const Tile &from) {
+    if (_valid && _origin == from &&
+        _collision_version == collision_version &&
+        _searched_overlay_version == _overlay_version)
+      return;
+
+    _valid = true;
+    _origin = from;
+    _collision_version = collision_version;
+    _searched_overlay_version = _overlay_version;
+
+    if (++_stamp == 0) {
+      std::fill(_stamps.begin(), _stamps.end(), 0);
+      _stamp = 1;
+    }
+
+    _queue.clear();
+
+    const auto visit = [&](std::int32_t x, std::int32_t y,
+                           std::uint16_t distance) {
+      const auto i = static_cast<std::uint32_t>(x * side + y);
+      if (_stamps[i] == _stamp)
+        return;
+
+      _stamps[i] = _stamp;
+      _distances[i] = distance;
+      _queue.push_back(i);
+    };
+
+    visit(radius, radius, 0);
+
+    constexpr std::int32_t directions[4][2] = {
+        {0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+
+    for (std::size_t head = 0; head < _queue.size(); ++head) {
+      const auto i = _queue[head];
+      const auto x = static_cast<std::int32_t>(i / side);
+      const auto y = static_cast<std::int32_t>(i % side);
+      const auto tile =
+          Tile(from.X + x - radius, from.Y + y - radius, from.Plane);
+
+      for (const auto &[dx, dy] : directions) {
+        const auto nx = x + dx;
+        const auto ny = y + dy;
+        if (nx < 0 || ny < 0 || nx >= side || ny >= side)
+          continue;
+
+        if (_can_step(tile, dx, dy))
+          visit(nx, ny, _distances[i] + 1);
+      }
+    }
+  }
+};
+
+local_reachability reachability;
+} // namespace as::web_walker
@@ -1,11 +1,53 @@
 #pragma once
 
 #include <Core/Types/Tile.hpp>
+#include <alpaca_script/mouse_camera.hpp>
+#include <alpaca_script/tick.hpp>
+#include <cstdint>
 #include <vector>
 
+#include "obstacle_timings.hpp"
 #include "path_finder_settings.hpp"
 
 namespace as::web_walker {
+enum class obstacle_kind : std::uint8_t {
+  door,
+  gate,
+  ladder,
+  trapdoor,
+  wilderness_gate,
+  game_object,
+  ground_object,
+  game_object_shortcut,
+  ground_object_shortcut,
+  mushtree,
+  custom, // any other obstacle class
+};
+
+// What passing an obstacle needs from the player, as plain data the path
+// finder checks without calling into the obstacle.
+class obstacle_requirements {
+public:
+  bool shortcut = false;   // needs use_shortcuts
+  bool wilderness = false; // leads into the wilderness, needs use_wilderness
+  std::int32_t agility_level = 0;
+
+  // quest and item requirements, one bit each, met when the same bits are
+  // set in path_finder_settings::unlocked
+  std::uint64_t flags = 0;
+
+  bool met_by(const path_finder_settings &settings) const {
+    if (shortcut && !settings.use_shortcuts)
+      return false;
+
+    if (wilderness && !settings.use_wilderness)
+      return false;
+
+    return settings.agility_level >= agility_level &&
+           (settings.unlocked & flags) == flags;
+  }
+};
+
 class obstacle {
 public:
   Tile destination;
@@ -20,15 +62,40 @@ public:
 
   Tile get_destination() const { return destination; }
 
+  virtual obstacle_kind kind() const { return obstacle_kind::custom; }
+
+  // Read once when the obstacle is added to the table. Built-in kinds state
+  // every requirement here, the path finder only asks can_handle of custom
+  // obstacles.
+  virtual obstacle_requirements requirements() const { return {}; }
+
   virtual bool can_handle(const path_finder_settings &settings) const {
-    return true;
+    return requirements().met_by(settings);
   }
 
+  // Called while the player walks the last leg before the obstacle, to turn
+  // the camera and find the object so handle can interact on arrival.
+  virtual void prepare() const {}
+
   virtual bool handle() const = 0;
 
   virtual ~obstacle() = default;
 };
 
+namespace detail {
+// turns the camera to the object and rests the mouse on it
+void approach_object(const auto &obj) {
+  if (!obj)
+    return;
+
+  if (obj.GetVisibility() < 0.5)
+    as::mouse_camera::rotate_to(obj.GetTile(), 20);
+
+  if (obj.GetVisibility() >= 0.5)
+    Interact::MoveMouse(obj.GetConvex().GetProfileHybridRandomPoint());
+}
+} // namespace detail
+
 class door_obstacle : public obstacle {
 public:
   Tile closed_position;
@@ -45,13 +112,20 @@ public:
   door_obstacle(Tile closed_position, Tile destination)
       : obstacle(destination), closed_position(closed_position) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::door; }
+
+  void prepare() const override {
+    detail::approach_object(WallObjects::Get(closed_position));
+  }
+
   bool handle() const override {
     auto obj = WallObjects::Get(closed_position);
     if (!obj)
       return true; // door open?
 
     obj.Interact("Open");
-    WaitFunc(2000, 50, [&]() { return !WallObjects::Get(closed_position); });
+    obstacle_timing.wait(
+        0, 2000, [&]() { return !WallObjects::Get(closed_position); });
 
     return true;
   }
@@ -73,22 +147,28 @@ public:
   gate_obstacle(Tile closed_position, Tile destination)
       : obstacle(destination), closed_position(closed_position) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::gate; }
+
+  void prepare() const override {
+    detail::approach_object(WallObjects::Get(closed_position));
+  }
+
   bool handle() const override {
     auto gate = WallObjects::Get(closed_position);
     if (gate) {
       if (!gate.Interact("Open"))
         return false;
 
-      if (!WaitFunc(2000, 50,
-                    [&]() { return !WallObjects::Get(closed_position); }))
+      if (!obstacle_timing.wait(
+              0, 2000, [&]() { return !WallObjects::Get(closed_position); }))
         return false;
     }
 
     if (!Mainscreen::ClickTile(destination))
       return false;
 
-    return WaitFunc(2000, 50, [&]() {
-      return Players::GetLocal().GetTile() == destination;
+    return obstacle_timing.wait(1, 2000, [&]() {
+      return tick::player().position == destination;
     });
   }
 };
@@ -115,6 +195,12 @@ public:
       : obstacle(std::move(destination)), tile(std::move(tile)),
         action(std::move(action)) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::game_object; }
+
+  void prepare() const override {
+    detail::approach_object(GameObjects::Get(tile));
+  }
+
   virtual bool handle() const override {
     auto player = Players::GetLocal();
     if (!player) {
@@ -133,7 +219,7 @@ public:
     if (!obj.Interact(action))
       return false;
 
-    if (!WaitFunc(2000, 50, [&]() {
+    if (!obstacle_timing.wait(0, 2000, [&]() {
           return (player.GetTile().DistanceFrom(destination) < 2 &&
                   player.GetTile().Plane == destination.Plane);
         })) {
@@ -166,6 +252,8 @@ public:
       : obstacle(std::move(destination)), tile(std::move(tile)),
         action(std::move(action)) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::ground_object; }
+
   virtual bool handle() const override {
     auto obj = GroundObjects::Get(tile);
     if (!obj) {
@@ -175,23 +263,31 @@ public:
   }
 };
 
-template <std::int32_t agility_level> class shortcut : public obstacle {
+class shortcut : public obstacle {
 public:
+  std::int32_t agility_level = 0;
+
   shortcut() = default;
 
-  shortcut(const shortcut &other) : obstacle(other.destination) {}
+  shortcut(const shortcut &other)
+      : obstacle(other.destination), agility_level(other.agility_level) {}
 
-  shortcut(shortcut &&other) : obstacle(std::move(other.destination)) {}
+  shortcut(shortcut &&other)
+      : obstacle(std::move(other.destination)),
+        agility_level(other.agility_level) {}
 
-  shortcut(Tile destination) : obstacle(destination) {}
+  shortcut(std::int32_t agility_level, Tile destination)
+      : obstacle(destination), agility_level(agility_level) {}
 
-  bool can_handle(const path_finder_settings &settings) const override {
-    return settings.use_shortcuts && settings.agility_level >= agility_level;
+  obstacle_requirements requirements() const override {
+    obstacle_requirements result;
+    result.shortcut = true;
+    result.agility_level = agility_level;
+    return result;
   }
 };
 
-template <std::int32_t agility_level>
-class game_object_shortcut : public shortcut<agility_level> {
+class game_object_shortcut : public shortcut {
 public:
   Tile tile;
   std::string action;
@@ -199,16 +295,23 @@ public:
   game_object_shortcut() = default;
 
   game_object_shortcut(const game_object_shortcut &other)
-      : shortcut<agility_level>(other), tile(other.tile), action(other.action) {
-  }
+      : shortcut(other), tile(other.tile), action(other.action) {}
 
   game_object_shortcut(game_object_shortcut &&other)
-      : shortcut<agility_level>(std::move(other)), tile(std::move(other.tile)),
+      : shortcut(std::move(other)), tile(std::move(other.tile)),
         action(std::move(other.action)) {}
 
-  game_object_shortcut(const Tile &tile, const std::string &action,
-                       const Tile &destination)
-      : shortcut<agility_level>(destination), tile(tile), action(action) {}
+  game_object_shortcut(std::int32_t agility_level, const Tile &tile,
+                       const std::string &action, const Tile &destination)
+      : shortcut(agility_level, destination), tile(tile), action(action) {}
+
+  obstacle_kind kind() const override {
+    return obstacle_kind::game_object_shortcut;
+  }
+
+  void prepare() const override {
+    detail::approach_object(GameObjects::Get(tile));
+  }
 
   bool handle() const override {
     auto player = Players::GetLocal();
@@ -220,8 +323,10 @@ public:
          player_tile.DistanceFrom(this->destination) > 2 &&
          player_tile.Plane == this->destination.Plane;
          player_tile = player.GetTile()) {
-      if (Mainscreen::IsMoving() || Mainscreen::IsAnimating()) {
-        Wait(50);
+      if (tick::player().moving || tick::player().animating) {
+        tick::wait(tick::length.count(), []() {
+          return !tick::player().moving && !tick::player().animating;
+        });
         continue;
       }
 
@@ -235,8 +340,8 @@ public:
       }
 
       obj.Interact(action);
-      WaitFunc(750, 50, []() {
-        return Mainscreen::IsMoving() || Mainscreen::IsAnimating();
+      tick::wait(750, []() {
+        return tick::player().moving || tick::player().animating;
       });
     }
 
@@ -244,8 +349,7 @@ public:
   }
 };
 
-template <std::int32_t agility_level>
-class ground_object_shortcut : public shortcut<agility_level> {
+class ground_object_shortcut : public shortcut {
 public:
   Tile tile;
   std::string action;
@@ -253,16 +357,19 @@ public:
   ground_object_shortcut() = default;
 
   ground_object_shortcut(const ground_object_shortcut &other)
-      : shortcut<agility_level>(other), tile(other.tile), action(other.action) {
-  }
+      : shortcut(other), tile(other.tile), action(other.action) {}
 
   ground_object_shortcut(ground_object_shortcut &&other)
-      : shortcut<agility_level>(std::move(other)), tile(std::move(other.tile)),
+      : shortcut(std::move(other)), tile(std::move(other.tile)),
         action(std::move(other.action)) {}
 
-  ground_object_shortcut(const Tile &tile, const std::string &action,
-                         const Tile &destination)
-      : shortcut<agility_level>(destination), tile(tile), action(action) {}
+  ground_object_shortcut(std::int32_t agility_level, const Tile &tile,
+                         const std::string &action, const Tile &destination)
+      : shortcut(agility_level, destination), tile(tile), action(action) {}
+
+  obstacle_kind kind() const override {
+    return obstacle_kind::ground_object_shortcut;
+  }
 
   bool handle() const override {
     auto player = Players::GetLocal();
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "obstacle.hpp"
+#include "obstacles/gate.hpp"
+#include "obstacles/ladder.hpp"
+#include "obstacles/magic_mushtree.hpp"
+#include "obstacles/trapdoor.hpp"
+#include "obstacles/wilderness_gate.hpp"
+#include "tile_key.hpp"
+
+namespace as::web_walker {
+// names used in catalogue files, indexed by obstacle_kind
+constexpr std::array<std::string_view, 10> obstacle_kind_names = {
+    "door",
+    "gate",
+    "ladder",
+    "trapdoor",
+    "wilderness_gate",
+    "game_object",
+    "ground_object",
+    "game_object_shortcut",
+    "ground_object_shortcut",
+    "mushtree",
+};
+
+obstacle_kind parse_obstacle_kind(std::string_view name) {
+  for (std::size_t i = 0; i < obstacle_kind_names.size(); ++i) {
+    if (obstacle_kind_names[i] == name)
+      return static_cast<obstacle_kind>(i);
+  }
+
+  throw std::runtime_error("unknown obstacle kind " + std::string(name));
+}
+
+// One catalogue entry, enough to construct the obstacle with make_obstacle.
+class obstacle_record {
+public:
+  obstacle_kind kind;
+  Tile tile;   // tile the obstacle is entered from
+  Tile object; // door, gate or object tile the handler interacts with
+  Tile destination;
+  std::string action;
+  std::int32_t agility_level = 0;
+};
+
+std::unique_ptr<obstacle> make_obstacle(const obstacle_record &record) {
+  switch (record.kind) {
+  case obstacle_kind::door:
+    return std::make_unique<door_obstacle>(record.object, record.destination);
+  case obstacle_kind::gate:
+    return std::make_unique<obstacles::gate>(record.object,
+                                             record.destination);
+  case obstacle_kind::ladder:
+    return std::make_unique<obstacles::ladder>(record.object,
+                                               record.destination);
+  case obstacle_kind::trapdoor:
+    return std::make_unique<obstacles::trapdoor>(record.object,
+                                                 record.destination);
+  case obstacle_kind::wilderness_gate:
+    return std::make_unique<obstacles::wilderness_gate>(record.object,
+                                                        record.destination);
+  case obstacle_kind::game_object:
+    return std::make_unique<game_object_obstacle>(record.object, record.action,
+                                                  record.destination);
+  case obstacle_kind::ground_object:
+    return std::make_unique<ground_object_obstacle>(
+        record.object, record.action, record.destination);
+  case obstacle_kind::game_object_shortcut:
+    return std::make_unique<game_object_shortcut>(
+        record.agility_level, record.object, record.action, record.destination);
+  case obstacle_kind::ground_object_shortcut:
+    return std::make_unique<ground_object_shortcut>(
+        record.agility_level, record.object, record.action, record.destination);
+  case obstacle_kind::mushtree:
+    return std::make_unique<obstacles::magic_mushroomtree>(record.destination);
+  case obstacle_kind::custom:
+    break;
+  }
+
+  throw std::runtime_error("unknown obstacle kind");
+}
+
+namespace detail {
+constexpr std::uint32_t catalogue_magic = 0x434f5341; // "ASOC"
+constexpr std::uint32_t catalogue_version = 1;
+
+// fixed size record of the binary catalogue, tiles stored as tile_key values
+class packed_obstacle_record {
+public:
+  std::uint8_t kind;
+  std::uint8_t agility_level;
+  std::uint16_t action; // index into the action table
+  std::uint32_t tile;
+  std::uint32_t object;
+  std::uint32_t destination;
+};
+
+static_assert(sizeof(packed_obstacle_record) == 16);
+
+Tile read_catalogue_tile(const nlohmann::json &json) {
+  return Tile(json["x"].get<std::int32_t>(), json["y"].get<std::int32_t>(),
+              json["plane"].get<std::int32_t>());
+}
+
+template <typename T> T read_catalogue_value(std::istream &is) {
+  T value{};
+  is.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return value;
+}
+
+// Reads a count of items of at least item_size bytes each, and throws when the
+// rest of the file is too short to hold them, before anything is sized by it.
+template <typename T>
+T read_catalogue_count(std::istream &is, std::uintmax_t size,
+                       std::uintmax_t item_size,
+                       const std::filesystem::path &file) {
+  const auto count = read_catalogue_value<T>(is);
+  const auto position = is.tellg();
+  if (!is || position < 0 ||
+      count > (size - static_cast<std::uintmax_t>(position)) / item_size) {
+    throw std::runtime_error("truncated obstacle catalogue " + file.string());
+  }
+
+  return count;
+}
+
+template <typename T>
+void write_catalogue_value(std::ostream &os, const T &value) {
+  os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+} // namespace detail
+
+// JSON catalogue: an array of entries of the form
+// {"kind": "door", "tile": {"x": 0, "y": 0, "plane": 0}, "object": {...},
+//  "destination": {...}, "action": "Open", "agility_level": 0}
+// where object defaults to tile, and action and agility_level are optional.
+std::vector<obstacle_record>
+read_obstacle_catalogue_json(const std::filesystem::path &file) {
+  auto ifs = std::ifstream(file, std::ios::in);
+  if (!ifs) {
+    throw std::runtime_error("failed to open " + file.string());
+  }
+
+  std::vector<obstacle_record> result;
+
+  auto json = nlohmann::json::parse(ifs);
+  result.reserve(json.size());
+  for (const auto &entry : json) {
+    obstacle_record record;
+    record.kind = parse_obstacle_kind(entry["kind"].get<std::string>());
+    record.tile = detail::read_catalogue_tile(entry["tile"]);
+    record.object = entry.contains("object")
+                        ? detail::read_catalogue_tile(entry["object"])
+                        : record.tile;
+    record.destination = detail::read_catalogue_tile(entry["destination"]);
+    record.action = entry.value("action", std::string());
+    record.agility_level = entry.value("agility_level", 0);
+    result.push_back(std::move(record));
+  }
+
+  return result;
+}
+
+// Binary catalogue: a header, the table of distinct actions and then the
+// fixed size records, which are read in one block.
+std::vector<obstacle_record>
+read_obstacle_catalogue_binary(const std::filesystem::path &file) {
+  auto ifs = std::ifstream(file, std::ios::in | std::ios::binary);
+  if (!ifs) {
+    throw std::runtime_error("failed to open " + file.string());
+  }
+
+  if (detail::read_catalogue_value<std::uint32_t>(ifs) !=
+          detail::catalogue_magic ||
+      detail::read_catalogue_value<std::uint32_t>(ifs) !=
+          detail::catalogue_version) {
+    throw std::runtime_error("unsupported obstacle catalogue " +
+                             file.string());
+  }
+
+  const auto size = std::filesystem::file_size(file);
+
+  // every action takes at least its 16-bit length
+  std::vector<std::string> actions(detail::read_catalogue_count<std::uint32_t>(
+      ifs, size, sizeof(std::uint16_t), file));
+  for (auto &action : actions) {
+    action.resize(
+        detail::read_catalogue_count<std::uint16_t>(ifs, size, 1, file));
+    ifs.read(action.data(), action.size());
+  }
+
+  std::vector<detail::packed_obstacle_record> packed(
+      detail::read_catalogue_count<std::uint32_t>(
+          ifs, size, sizeof(detail::packed_obstacle_record), file));
+  ifs.read(reinterpret_cast<char *>(packed.data()),
+           packed.size() * sizeof(detail::packed_obstacle_record));
+
+  if (!ifs) {
+    throw std::runtime_error("truncated obstacle catalogue " + file.string());
+  }
+
+  std::vector<obstacle_record> result;
+  result.reserve(packed.size());
+  for (const auto &p : packed) {
+    if (p.kind >= obstacle_kind_names.size() || p.action >= actions.size()) {
+      throw std::runtime_error("corrupt obstacle catalogue " + file.string());
+    }
+
+    result.push_back(obstacle_record{
+        static_cast<obstacle_kind>(p.kind), tile_key(p.tile).to_tile(),
+        tile_key(p.object).to_tile(), tile_key(p.destination).to_tile(),
+        actions[p.action], p.agility_level});
+  }
+
+  return result;
+}
+
+std::vector<obstacle_record>
+read_obstacle_catalogue(const std::filesystem::path &file) {
+  if (file.extension() == ".json")
+    return read_obstacle_catalogue_json(file);
+
+  return read_obstacle_catalogue_binary(file);
+}
+
+void write_obstacle_catalogue(const std::filesystem::path &file,
+                              const std::vector<obstacle_record> &records) {
+  std::vector<std::string> actions;
+  std::unordered_map<std::string, std::uint16_t> action_index;
+
+  std::vector<detail::packed_obstacle_record> packed;
+  packed.reserve(records.size());
+  for (const auto &record : records) {
+    auto [it, inserted] = action_index.try_emplace(
+        record.action, static_cast<std::uint16_t>(actions.size()));
+    if (inserted)
+      actions.push_back(record.action);
+
+    packed.push_back(detail::packed_obstacle_record{
+        static_cast<std::uint8_t>(record.kind),
+        static_cast<std::uint8_t>(record.agility_level), it->second,
+        tile_key(record.tile).value, tile_key(record.object).value,
+        tile_key(record.destination).value});
+  }
+
+  auto ofs = std::ofstream(file, std::ios::out | std::ios::binary);
+  if (!ofs) {
+    throw std::runtime_error("failed to open " + file.string());
+  }
+
+  detail::write_catalogue_value(ofs, detail::catalogue_magic);
+  detail::write_catalogue_value(ofs, detail::catalogue_version);
+
+  detail::write_catalogue_value(ofs,
+                                static_cast<std::uint32_t>(actions.size()));
+  for (const auto &action : actions) {
+    detail::write_catalogue_value(ofs,
+                                  static_cast<std::uint16_t>(action.size()));
+    ofs.write(action.data(), action.size());
+  }
+
+  detail::write_catalogue_value(ofs,
+                                static_cast<std::uint32_t>(packed.size()));
+  ofs.write(reinterpret_cast<const char *>(packed.data()),
+            packed.size() * sizeof(detail::packed_obstacle_record));
+}
+} // namespace as::web_walker
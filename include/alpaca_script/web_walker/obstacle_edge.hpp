@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include "obstacle.hpp"
+#include "path_finder_settings.hpp"
+#include "tile_key.hpp"
+
+namespace as::web_walker {
+// Search-side copy of an obstacle, everything the path finder reads for each
+// edge without touching the handler. The requirements are copied from the
+// handler when the edge is built, only custom obstacles still have their
+// virtual can_handle asked during the search.
+class obstacle_edge {
+public:
+  tile_key destination;
+  obstacle_kind kind = obstacle_kind::custom;
+  obstacle_requirements requirements;
+  const obstacle *handler = nullptr;
+
+  obstacle_edge() = default;
+
+  obstacle_edge(const obstacle &obs)
+      : destination(obs.destination), kind(obs.kind()),
+        requirements(obs.requirements()), handler(&obs) {}
+
+  bool can_handle(const path_finder_settings &settings) const {
+    if (!requirements.met_by(settings))
+      return false;
+
+    return kind != obstacle_kind::custom || handler->can_handle(settings);
+  }
+};
+} // namespace as::web_walker
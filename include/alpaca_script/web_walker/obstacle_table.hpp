@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "obstacle.hpp"
+#include "obstacle_edge.hpp"
+#include "tile_key.hpp"
+
+namespace as::web_walker {
+// Obstacles keyed by the tile they are entered from. Entries are stored
+// contiguously and sorted by key, so the obstacles of one tile form a span.
+// Spans are found through a flat open-addressing index, and a bit filter in
+// front of it rejects almost every tile without an obstacle with one bit test.
+// Next to every entry the table keeps its obstacle_edge, so the search reads
+// plain data instead of the heap allocated handlers.
+class obstacle_table {
+public:
+  using value_type = std::pair<tile_key, std::unique_ptr<obstacle>>;
+
+  using const_iterator = std::vector<value_type>::const_iterator;
+
+  // bits in the miss filter, a power of two
+  static constexpr std::size_t filter_bits = std::size_t(1) << 16;
+
+  obstacle_table() { _reindex(); }
+
+  // Adds one entry and indexes the whole table again, so filling a table one
+  // entry at a time is quadratic. Build tables with assign instead, this is
+  // for the odd entry added to a finished table.
+  void emplace(const tile_key &key, std::unique_ptr<obstacle> obs) {
+    auto it = std::upper_bound(
+        _entries.begin(), _entries.end(), key,
+        [](const tile_key &k, const value_type &e) { return k < e.first; });
+    _entries.emplace(it, key, std::move(obs));
+    _reindex();
+  }
+
+  // Replaces the contents with the given entries, indexing only once.
+  void assign(std::vector<value_type> entries) {
+    _entries = std::move(entries);
+    std::stable_sort(
+        _entries.begin(), _entries.end(),
+        [](const value_type &a, const value_type &b) {
+          return a.first < b.first;
+        });
+    _reindex();
+  }
+
+  void clear() {
+    _entries.clear();
+    _reindex();
+  }
+
+  bool may_contain(const tile_key &key) const {
+    const auto bit = _hash(key) & (filter_bits - 1);
+    return (_filter[bit / 64] >> (bit % 64)) & 1;
+  }
+
+  std::pair<const_iterator, const_iterator>
+  equal_range(const tile_key &key) const {
+    auto s = _find(key);
+    if (!s)
+      return {end(), end()};
+
+    const auto first = begin() + s->first;
+    return {first, first + s->count};
+  }
+
+  // the edges of the obstacles entered from key, in the order of equal_range
+  std::pair<const obstacle_edge *, const obstacle_edge *>
+  edges(const tile_key &key) const {
+    auto s = _find(key);
+    if (!s)
+      return {nullptr, nullptr};
+
+    const auto first = _edges.data() + s->first;
+    return {first, first + s->count};
+  }
+
+  std::size_t count(const tile_key &key) const {
+    auto [first, last] = equal_range(key);
+    return static_cast<std::size_t>(std::distance(first, last));
+  }
+
+  const_iterator begin() const { return _entries.begin(); }
+
+  const_iterator end() const { return _entries.end(); }
+
+  std::size_t size() const { return _entries.size(); }
+
+  bool empty() const { return _entries.empty(); }
+
+private:
+  class slot {
+  public:
+    tile_key key;
+    std::uint32_t first = 0;
+    std::uint32_t count = 0; // 0 marks an empty slot
+  };
+
+  std::vector<value_type> _entries;
+  std::vector<obstacle_edge> _edges;
+  std::vector<slot> _slots;
+  std::array<std::uint64_t, filter_bits / 64> _filter;
+
+  static std::uint32_t _hash(const tile_key &key) {
+    return static_cast<std::uint32_t>(std::hash<tile_key>{}(key));
+  }
+
+  const slot *_find(const tile_key &key) const {
+    if (!may_contain(key))
+      return nullptr;
+
+    const auto mask = _slots.size() - 1;
+    for (auto i = (_hash(key) >> 16) & mask;; i = (i + 1) & mask) {
+      const auto &s = _slots[i];
+      if (s.count == 0)
+        return nullptr;
+
+      if (s.key == key)
+        return &s;
+    }
+  }
+
+  void _reindex() {
+    _filter.fill(0);
+
+    _edges.clear();
+    _edges.reserve(_entries.size());
+    for (const auto &[key, obs] : _entries)
+      _edges.emplace_back(*obs);
+
+    // keep the index at most half full
+    std::size_t capacity = 16;
+    while (capacity < _entries.size() * 2)
+      capacity *= 2;
+
+    _slots.assign(capacity, slot{});
+
+    const auto mask = capacity - 1;
+    for (std::size_t first = 0; first < _entries.size();) {
+      const auto key = _entries[first].first;
+      auto last = first + 1;
+      while (last < _entries.size() && _entries[last].first == key)
+        ++last;
+
+      const auto h = _hash(key);
+      const auto bit = h & (filter_bits - 1);
+      _filter[bit / 64] |= std::uint64_t(1) << (bit % 64);
+
+      auto i = (h >> 16) & mask;
+      while (_slots[i].count != 0)
+        i = (i + 1) & mask;
+
+      _slots[i] = slot{key, static_cast<std::uint32_t>(first),
+                       static_cast<std::uint32_t>(last - first)};
+      first = last;
+    }
+  }
+};
+} // namespace as::web_walker
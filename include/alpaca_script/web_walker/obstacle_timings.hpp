@@ -0,0 +1,253 @@
+#pragma once
+
+#include <alpaca_script/tick.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace as::web_walker {
+// Streaming histogram of latencies in log spaced buckets, each about 19%
+// wider than the one before, from 10 ms to about 40 s. Counts are halved once
+// they reach max_samples, so old observations fade out. Waits that timed out
+// have no latency and are only counted, beside the buckets.
+class latency_histogram {
+public:
+  static constexpr std::size_t buckets = 48;
+
+  static constexpr std::uint32_t max_samples = 512;
+
+  // upper bound of bucket i in ms
+  static double bound(std::size_t i) {
+    return 10.0 * std::exp2((i + 1) / 4.0);
+  }
+
+  std::array<std::uint32_t, buckets> counts{};
+  std::uint32_t total = 0;
+  std::uint32_t timed_out = 0;
+
+  void add(std::uint32_t ms) {
+    std::size_t i = 0;
+    while (i + 1 < buckets && bound(i) < ms)
+      ++i;
+
+    ++counts[i];
+    if (++total < max_samples)
+      return;
+
+    total = 0;
+    for (auto &count : counts) {
+      count /= 2;
+      total += count;
+    }
+
+    timed_out /= 2;
+  }
+
+  void add_timeout() { timed_out = std::min(timed_out + 1, max_samples); }
+
+  // upper bound of the bucket holding the given quantile, in ms
+  std::uint32_t quantile(double q) const {
+    const auto target = static_cast<std::uint32_t>(std::ceil(q * total));
+
+    std::uint32_t seen = 0;
+    for (std::size_t i = 0; i < buckets; ++i) {
+      seen += counts[i];
+      if (seen >= target && seen > 0)
+        return static_cast<std::uint32_t>(bound(i));
+    }
+
+    return static_cast<std::uint32_t>(bound(buckets - 1));
+  }
+};
+
+// Completion latencies of the waits in obstacle handlers, per obstacle and
+// per stage of its handler, used to replace their fixed timeouts. The walker
+// names the obstacle being handled with begin and end. Handlers called
+// outside of that, or without enough history, wait their fallback timeout.
+class obstacle_timings {
+public:
+  // samples needed before the learnt timeout is used
+  static constexpr std::uint32_t min_samples = 8;
+
+  static constexpr double quantile = 0.99;
+
+  // added to the quantile, and the shortest timeout ever used, one tick
+  static constexpr auto margin =
+      static_cast<std::uint32_t>(tick::length.count());
+
+  // the learnt timeout is never longer than this many fallback timeouts
+  static constexpr std::uint32_t max_fallbacks = 4;
+
+  // the fallback is used again once more than one in this many waits timed
+  // out, as the learnt timeout may be too short
+  static constexpr std::uint32_t max_timeout_share = 8;
+
+  // Names the obstacle being handled for as long as it lives, also when the
+  // handler throws.
+  class handling {
+  public:
+    handling(obstacle_timings &timings, std::uint32_t obstacle)
+        : _timings(timings) {
+      _timings.begin(obstacle);
+    }
+
+    handling(const handling &) = delete;
+    handling &operator=(const handling &) = delete;
+
+    ~handling() { _timings.end(); }
+
+  private:
+    obstacle_timings &_timings;
+  };
+
+  void begin(std::uint32_t obstacle) {
+    _obstacle = obstacle;
+    _active = true;
+  }
+
+  void end() { _active = false; }
+
+  void record(std::uint64_t key, std::uint32_t ms) { _timings[key].add(ms); }
+
+  std::uint32_t timeout(std::uint64_t key, std::uint32_t fallback) const {
+    auto it = _timings.find(key);
+    if (it == _timings.end() || it->second.total < min_samples ||
+        it->second.timed_out * max_timeout_share > it->second.total)
+      return fallback;
+
+    return std::clamp(it->second.quantile(quantile) + margin, margin,
+                      fallback * max_fallbacks);
+  }
+
+  // tick::wait with the timeout learnt for the given stage of the obstacle
+  // being handled. A wait that times out is only counted: recording it at its
+  // timeout would let every genuine failure, like a door that never opens,
+  // raise the quantile and ratchet the timeout up. Too many of them switch
+  // back to the fallback instead.
+  bool wait(std::uint8_t stage, std::uint32_t fallback,
+            const std::function<bool()> &predicate) {
+    if (!_active)
+      return tick::wait(fallback, predicate);
+
+    const auto key = _key(_obstacle, stage);
+    const auto limit = timeout(key, fallback);
+    const auto started = tick::clock_type::now();
+    if (!tick::wait(limit, predicate)) {
+      _timings[key].add_timeout();
+      return false;
+    }
+
+    record(key, static_cast<std::uint32_t>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        tick::clock_type::now() - started)
+                        .count()));
+    return true;
+  }
+
+  void clear() { _timings.clear(); }
+
+  std::size_t size() const { return _timings.size(); }
+
+  // {"version": 1, "timings": {"<key>": [count, ...]},
+  //  "timeouts": {"<key>": count}}, timeouts is optional
+  void load(const std::filesystem::path &file) {
+    auto ifs = std::ifstream(file, std::ios::in);
+    if (!ifs) {
+      throw std::runtime_error("failed to open " + file.string());
+    }
+
+    auto json = nlohmann::json::parse(ifs);
+    if (json.value("version", 0) != format_version) {
+      throw std::runtime_error("unsupported obstacle timings " +
+                               file.string());
+    }
+
+    for (const auto &item : json["timings"].items()) {
+      const auto &counts = item.value();
+
+      latency_histogram histogram;
+      for (std::size_t i = 0; i < counts.size() && i < histogram.buckets;
+           ++i) {
+        histogram.counts[i] = counts[i].get<std::uint32_t>();
+        histogram.total += histogram.counts[i];
+      }
+
+      _timings.insert_or_assign(std::stoull(item.key()), histogram);
+    }
+
+    if (json.contains("timeouts")) {
+      for (const auto &item : json["timeouts"].items()) {
+        _timings[std::stoull(item.key())].timed_out = std::min(
+            item.value().get<std::uint32_t>(), latency_histogram::max_samples);
+      }
+    }
+  }
+
+  void save(const std::filesystem::path &file) const {
+    auto json = nlohmann::json::object();
+    json["version"] = format_version;
+    json["timings"] = nlohmann::json::object();
+    json["timeouts"] = nlohmann::json::object();
+    for (const auto &[key, histogram] : _timings) {
+      auto counts = nlohmann::json::array();
+      for (auto count : histogram.counts)
+        counts.push_back(count);
+
+      json["timings"][std::to_string(key)] = counts;
+      if (histogram.timed_out > 0)
+        json["timeouts"][std::to_string(key)] = histogram.timed_out;
+    }
+
+    auto ofs = std::ofstream(file, std::ios::out);
+    if (!ofs) {
+      throw std::runtime_error("failed to open " + file.string());
+    }
+
+    ofs << json.dump();
+  }
+
+private:
+  static constexpr std::int32_t format_version = 1;
+
+  std::unordered_map<std::uint64_t, latency_histogram> _timings;
+  std::uint32_t _obstacle = 0;
+  bool _active = false;
+
+  static std::uint64_t _key(std::uint32_t obstacle, std::uint8_t stage) {
+    return (static_cast<std::uint64_t>(obstacle) << 8) | stage;
+  }
+};
+
+obstacle_timings obstacle_timing;
+
+std::filesystem::path default_obstacle_timings_file() {
+  const char *user_profile = std::getenv("USERPROFILE");
+  if (user_profile == nullptr) {
+    throw std::runtime_error("failed to get USERPROFILE");
+  }
+
+  return std::filesystem::path(user_profile) / "AlpacaBot" /
+         "Obstacle Timings.json";
+}
+
+// Loads the timings saved by an earlier run, if there are any.
+void load_obstacle_timings() {
+  const auto file = default_obstacle_timings_file();
+  if (std::filesystem::exists(file))
+    obstacle_timing.load(file);
+}
+
+void save_obstacle_timings() {
+  obstacle_timing.save(default_obstacle_timings_file());
+}
+} // namespace as::web_walker
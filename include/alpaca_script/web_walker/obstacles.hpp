@@ -1,169 +1,210 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "collision.hpp"
 #include "obstacle.hpp"
-#include "obstacles/gate.hpp"
-#include "obstacles/ladder.hpp"
-#include "obstacles/magic_mushtree.hpp"
-#include "obstacles/trapdoor.hpp"
-#include "obstacles/wilderness_gate.hpp"
+#include "obstacle_catalogue.hpp"
+#include "obstacle_table.hpp"
 
 namespace as::web_walker {
 
-using obstacle_map_t = std::unordered_multimap<Tile, std::unique_ptr<obstacle>>;
+using obstacle_map_t = obstacle_table;
 
-obstacle_map_t obstacle_map = []() {
-  obstacle_map_t result;
+// obstacles known without a catalogue file
+const std::vector<obstacle_record> builtin_obstacles = {
+    // == Lumbridge ==
+
+    // -- General Store --
+
+    // Door (entering)
+    {obstacle_kind::door, Tile(3215, 3245, 0), Tile(3215, 3245, 0),
+     Tile(3214, 3245, 0)},
+
+    // Door (exiting)
+    {obstacle_kind::door, Tile(3214, 3245, 0), Tile(3215, 3245, 0),
+     Tile(3215, 3245, 0)},
+
+    // -- Lumbridge Castle --
+
+    // kitchen trapdoor (climb down)
+    {obstacle_kind::ground_object, Tile(3209, 3216, 0), Tile(3209, 3216, 0),
+     Tile(3210, 9616, 0), "Climb down"},
+
+    // basement ladder (climb up)
+    {obstacle_kind::game_object, Tile(3209, 9616, 0), Tile(3209, 9616, 0),
+     Tile(3210, 3216, 0), "Climb-up"},
+
+    // first floor south stairs (climb up)
+    {obstacle_kind::game_object, Tile(3205, 3208, 0), Tile(3205, 3208, 0),
+     Tile(3205, 3209, 1), "Climb-up"},
+
+    // second floor south stairs (climb up)
+    {obstacle_kind::game_object, Tile(3205, 3208, 1), Tile(3205, 3208, 1),
+     Tile(3205, 3209, 2), "Climb-up"},
+
+    // second floor south stairs (climb down)
+    {obstacle_kind::game_object, Tile(3205, 3209, 1), Tile(3205, 3208, 1),
+     Tile(3206, 3208, 0), "Climb-down"},
+
+    // third floor south stairs (climb down)
+    {obstacle_kind::game_object, Tile(3205, 3208, 2), Tile(3205, 3208, 2),
+     Tile(3206, 3208, 1), "Climb-down"},
+
+    // == Varrock ==
+
+    // == Grand Exchange ==
+    // Underwall tunnel GE -> Edgeville
+    {obstacle_kind::game_object_shortcut, Tile(3141, 3513, 0),
+     Tile(3141, 3513, 0), Tile(3138, 3516, 0), "Climb-into", 21},
+
+    // Underwall tunnel Edgeville -> GE
+    {obstacle_kind::game_object_shortcut, Tile(3138, 3516, 0),
+     Tile(3138, 3516, 0), Tile(3142, 3513, 0), "Climb-into", 21},
+
+    // == Edgeville ==
 
-  // == Lumbridge ==
-
-  // -- General Store --
-
-  // Door (entering)
-  result.emplace(
-      Tile(3215, 3245, 0),
-      std::make_unique<door_obstacle>(Tile(3215, 3245, 0), // Closed position
-                                      Tile(3214, 3245, 0)  // Destination
-                                      ));
-
-  // Door (exiting)
-  result.emplace(
-      Tile(3214, 3245, 0),
-      std::make_unique<door_obstacle>(Tile(3215, 3245, 0), // Closed position
-                                      Tile(3215, 3245, 0)  // Destination
-                                      ));
-  // -- Lumbridge Castle --
-
-  // kitchen trapdoor (climb down)
-  result.emplace(Tile(3209, 3216, 0),
-                 std::make_unique<ground_object_obstacle>(
-                     Tile(3209, 3216, 0), // Object tile
-                     "Climb down",        // Action
-                     Tile(3210, 9616, 0)  // Destination tile
-                     ));
-
-  // basement ladder (climb up)
-  result.emplace(Tile(3209, 9616, 0),
-                 std::make_unique<game_object_obstacle>(
-                     Tile(3209, 9616, 0), // Object tile
-                     "Climb-up",          // Action
-                     Tile(3210, 3216, 0)  // Destination tile
-                     ));
-
-  // first floor south stairs (climb up)
-  result.emplace(Tile(3205, 3208, 0), std::make_unique<game_object_obstacle>(
-                                          Tile(3205, 3208, 0), // Object Tile
-                                          "Climb-up",          // Action
-                                          Tile(3205, 3209, 1)  // Destination
-                                          ));
-
-  // second floor south stairs (climb up)
-  result.emplace(Tile(3205, 3208, 1), std::make_unique<game_object_obstacle>(
-                                          Tile(3205, 3208, 1), // Object Tile
-                                          "Climb-up",          // Action
-                                          Tile(3205, 3209, 2)  // Destination
-                                          ));
-
-  // second floor south stairs (climb down)
-  result.emplace(Tile(3205, 3209, 1), std::make_unique<game_object_obstacle>(
-                                          Tile(3205, 3208, 1), // Object Tile
-                                          "Climb-down",        // Action
-                                          Tile(3206, 3208, 0)  // Destination
-                                          ));
-
-  // third floor south stairs (climb down)
-  result.emplace(Tile(3205, 3208, 2), std::make_unique<game_object_obstacle>(
-                                          Tile(3205, 3208, 2), // Object Tile
-                                          "Climb-down",        // Action
-                                          Tile(3206, 3208, 1)  // Destination
-                                          ));
-
-  // == Varrock ==
-
-  // == Grand Exchange ==
-  // Underwall tunnel GE -> Edgeville
-  result.emplace(Tile(3141, 3513, 0),
-                 std::make_unique<game_object_shortcut<21>>(
-                     Tile(3141, 3513, 0), // Object Tile
-                     "Climb-into",        // Action
-                     Tile(3138, 3516, 0)  // Destination
-                     ));
-
-  // Underwall tunnel Edgeville -> GE
-  result.emplace(Tile(3138, 3516, 0),
-                 std::make_unique<game_object_shortcut<21>>(
-                     Tile(3138, 3516, 0), // Object Tile
-                     "Climb-into",        // Action
-                     Tile(3142, 3513, 0)  // Destination
-                     ));
-
-  // == Edgeville ==
-
-  // Trapdoor Edgeville -> Edgeville dungeon
-  result.emplace(Tile(3097, 3468, 0), std::make_unique<obstacles::trapdoor>(
-                                          Tile(3097, 3468, 0), // Object Tile
-                                          Tile(3096, 9867, 0)  // Destination
-                                          ));
-
-  // == Edgeville dungeon ==
-
-  // Ladder Edgeville Dungeon -> Edgeville
-  result.emplace(Tile(3096, 9867, 0), std::make_unique<obstacles::ladder>(
-                                          Tile(3096, 9867, 0), // Object
-                                          Tile(3096, 3468, 0)));
-
-  // First gate
-  result.emplace(Tile(3103, 9909, 0), std::make_unique<obstacles::gate>(
-                                          Tile(3103, 9909, 0), // Object
-                                          Tile(3104, 9909, 0)  // Destination
-                                          ));
-  // Wilderness entrance gate
-  result.emplace(Tile(3131, 9917, 0),
-                 std::make_unique<obstacles::wilderness_gate>(
-                     Tile(3131, 9917, 0), // Object
-                     Tile(3131, 9918, 0)  // Destination
-                     ));
-  // Chaos druids gate
-  result.emplace(Tile(3106, 9944, 0), std::make_unique<obstacles::gate>(
-                                          Tile(3106, 9944, 0), // Object
-                                          Tile(3106, 9945, 0)  // Destination
-                                          ));
-
-  // Air obelisk ladder (climb up)
-  result.emplace(Tile(3088, 9970, 0), std::make_unique<obstacles::ladder>(
-                                          Tile(3088, 9971, 0), // Object Tile
-                                          Tile(3088, 3570, 0)  // Destination
-                                          ));
-
-  // == Wilderness ==
-
-  // Lava dragons gate
-
-  // Entering
-  result.emplace(Tile(3201, 3856, 0), std::make_unique<obstacles::gate>(
-                                          Tile(3201, 3856, 0), // Object
-                                          Tile(3201, 3855, 0)  // Destination
-                                          ));
-
-  // Exiting
-  result.emplace(Tile(3201, 3855, 0), std::make_unique<obstacles::gate>(
-                                          Tile(3201, 3856, 0), // Object
-                                          Tile(3201, 3856, 0)  // Destination
-                                          ));
-  // == Fossil Island ==
-  // Mushroom Meadow mushtree
-  result.emplace(
-      Tile(3676, 3871, 0),
-      std::make_unique<obstacles::magic_mushroomtree>(Tile(3760, 3758, 0)));
-
-  // Verdant valley mushtree
-  result.emplace(
-      Tile(3757, 3757, 0),
-      std::make_unique<obstacles::magic_mushroomtree>(Tile(3676, 3871, 0)));
+    // Trapdoor Edgeville -> Edgeville dungeon
+    {obstacle_kind::trapdoor, Tile(3097, 3468, 0), Tile(3097, 3468, 0),
+     Tile(3096, 9867, 0)},
 
+    // == Edgeville dungeon ==
+
+    // Ladder Edgeville Dungeon -> Edgeville
+    {obstacle_kind::ladder, Tile(3096, 9867, 0), Tile(3096, 9867, 0),
+     Tile(3096, 3468, 0)},
+
+    // First gate
+    {obstacle_kind::gate, Tile(3103, 9909, 0), Tile(3103, 9909, 0),
+     Tile(3104, 9909, 0)},
+
+    // Wilderness entrance gate
+    {obstacle_kind::wilderness_gate, Tile(3131, 9917, 0), Tile(3131, 9917, 0),
+     Tile(3131, 9918, 0)},
+
+    // Chaos druids gate
+    {obstacle_kind::gate, Tile(3106, 9944, 0), Tile(3106, 9944, 0),
+     Tile(3106, 9945, 0)},
+
+    // Air obelisk ladder (climb up)
+    {obstacle_kind::ladder, Tile(3088, 9970, 0), Tile(3088, 9971, 0),
+     Tile(3088, 3570, 0)},
+
+    // == Wilderness ==
+
+    // Lava dragons gate
+
+    // Entering
+    {obstacle_kind::gate, Tile(3201, 3856, 0), Tile(3201, 3856, 0),
+     Tile(3201, 3855, 0)},
+
+    // Exiting
+    {obstacle_kind::gate, Tile(3201, 3855, 0), Tile(3201, 3856, 0),
+     Tile(3201, 3856, 0)},
+
+    // == Fossil Island ==
+    // Mushroom Meadow mushtree
+    {obstacle_kind::mushtree, Tile(3676, 3871, 0), Tile(3676, 3871, 0),
+     Tile(3760, 3758, 0)},
+
+    // Verdant valley mushtree
+    {obstacle_kind::mushtree, Tile(3757, 3757, 0), Tile(3757, 3757, 0),
+     Tile(3676, 3871, 0)},
+};
+
+obstacle_map_t make_obstacle_map(const std::vector<obstacle_record> &records) {
+  std::vector<obstacle_map_t::value_type> entries;
+  entries.reserve(records.size());
+  for (const auto &record : records)
+    entries.emplace_back(record.tile, make_obstacle(record));
+
+  obstacle_map_t result;
+  result.assign(std::move(entries));
   return result;
-}();
+}
+
+obstacle_map_t obstacle_map = make_obstacle_map(builtin_obstacles);
+
+// Changes whenever obstacle_map is rebuilt, which invalidates every obstacle
+// pointer taken from it.
+std::uint64_t obstacle_version = 0;
+
+
+// Stable id of an obstacle, derived from the tile it is registered at and its
+// destination so it survives restarts and reordering of obstacle_map.
+std::uint32_t obstacle_id(const tile_key &tile, const tile_key &destination) {
+  return static_cast<std::uint32_t>(detail::mix(
+      (static_cast<std::uint64_t>(tile.value) << 32) | destination.value));
+}
+
+std::uint32_t obstacle_id(const tile_key &tile, const obstacle &obs) {
+  return obstacle_id(tile, obs.destination);
+}
+
+const obstacle *find_obstacle(std::uint32_t id) {
+  for (const auto &[tile, obs] : obstacle_map) {
+    if (obstacle_id(tile, *obs) == id)
+      return obs.get();
+  }
+
+  return nullptr;
+}
+
+// Rebuilds obstacle_map from the built-in obstacles and every .json and .bin
+// catalogue in the given directory. A catalogue entry replaces an earlier one
+// with the same obstacle_id.
+void load_obstacles(const std::filesystem::path &path_to_data) {
+  if (!std::filesystem::is_directory(path_to_data)) {
+    throw std::runtime_error("path_to_data is not a directory");
+  }
+
+  std::vector<std::filesystem::path> files;
+  for (const auto &dir_entry :
+       std::filesystem::directory_iterator(path_to_data)) {
+    const auto extension = dir_entry.path().extension();
+    if (dir_entry.is_regular_file() &&
+        (extension == ".json" || extension == ".bin"))
+      files.push_back(dir_entry.path());
+  }
+
+  // later files override earlier ones, so load them in a stable order
+  std::sort(files.begin(), files.end());
+
+  auto records = builtin_obstacles;
+  std::unordered_map<std::uint32_t, std::size_t> index;
+  for (std::size_t i = 0; i < records.size(); ++i)
+    index[obstacle_id(records[i].tile, records[i].destination)] = i;
+
+  for (const auto &file : files) {
+    for (auto &record : read_obstacle_catalogue(file)) {
+      const auto id = obstacle_id(record.tile, record.destination);
+      auto [it, inserted] = index.try_emplace(id, records.size());
+      if (inserted)
+        records.push_back(std::move(record));
+      else
+        records[it->second] = std::move(record);
+    }
+  }
+
+  obstacle_map = make_obstacle_map(records);
+  ++obstacle_version;
+}
+
+// Loads the catalogues in AlpacaBot/Obstacle Data, if there are any.
+void load_obstacles() {
+  const char *user_profile = std::getenv("USERPROFILE");
+  if (user_profile == nullptr) {
+    throw std::runtime_error("failed to get USERPROFILE");
+  }
+
+  auto path_to_data =
+      std::filesystem::path(user_profile) / "AlpacaBot" / "Obstacle Data";
+  if (std::filesystem::exists(path_to_data))
+    load_obstacles(path_to_data);
+}
 } // namespace as::web_walker
\ No newline at end of file
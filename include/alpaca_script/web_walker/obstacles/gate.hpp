@@ -11,6 +11,12 @@ public:
   gate(Tile closed_position, Tile destination)
       : obstacle(destination), closed_position(closed_position) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::gate; }
+
+  void prepare() const override {
+    detail::approach_object(WallObjects::Get(closed_position));
+  }
+
   bool handle() const override {
     const auto gate = WallObjects::Get(closed_position);
     if (!gate)
@@ -19,8 +25,8 @@ public:
     if (!gate.Interact("Open"))
       return false;
 
-    return WaitFunc(2000, 50,
-                    [&]() { return !WallObjects::Get(closed_position); });
+    return obstacle_timing.wait(
+        0, 2000, [&]() { return !WallObjects::Get(closed_position); });
   }
 };
 } // namespace as::web_walker::obstacles
\ No newline at end of file
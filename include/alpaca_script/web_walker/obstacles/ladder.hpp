@@ -11,6 +11,12 @@ public:
   ladder(Tile object_tile, Tile destination)
       : obstacle(destination), object_tile(object_tile) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::ladder; }
+
+  void prepare() const override {
+    detail::approach_object(GameObjects::Get(object_tile));
+  }
+
   bool handle() const override {
     auto obj = GameObjects::Get(object_tile);
 
@@ -20,8 +26,8 @@ public:
     if (!obj.Interact("Climb-up"))
       return false;
 
-    return WaitFunc(2500, 50,
-                    [&]() { return Minimap::GetPosition() == destination; });
+    return obstacle_timing.wait(
+        0, 2500, [&]() { return tick::player().position == destination; });
   }
 };
 }; // namespace as::web_walker::obstacles
\ No newline at end of file
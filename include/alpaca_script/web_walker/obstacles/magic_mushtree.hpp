@@ -1,15 +1,18 @@
 #pragma once
 
 #include <alpaca_script/web_walker/obstacle.hpp>
+#include <alpaca_script/web_walker/tile_key.hpp>
 
 namespace as::web_walker::obstacles {
 class magic_mushroomtree : public obstacle {
 public:
-  static std::unordered_map<Tile, std::pair<std::int32_t, std::int32_t>>
+  static std::unordered_map<tile_key, std::pair<std::int32_t, std::int32_t>>
       transport_widget_map;
 
   magic_mushroomtree(Tile destination) : obstacle(destination) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::mushtree; }
+
   bool handle() const override {
     const auto tree = GameObjects::Get("Magic Mushtree");
 
@@ -22,7 +25,7 @@ public:
       if (!tree.Interact("Use"))
         return false;
 
-      if (!WaitFunc(2250, 50, [&]() {
+      if (!obstacle_timing.wait(0, 2250, [&]() {
             transport_widget = Widgets::Get(608, 0);
             return transport_widget.IsVisible();
           }))
@@ -35,12 +38,12 @@ public:
     if (!widg.Interact("Continue"))
       return false;
 
-    return WaitFunc(4000, 50,
-                    [&]() { return Minimap::GetPosition() == destination; });
+    return obstacle_timing.wait(
+        1, 4000, [&]() { return tick::player().position == destination; });
   }
 };
 
-std::unordered_map<Tile, std::pair<std::int32_t, std::int32_t>>
+std::unordered_map<tile_key, std::pair<std::int32_t, std::int32_t>>
     magic_mushroomtree::transport_widget_map = {
         {Tile(3760, 3758, 0), {608, 8}},  // verdant valley
         {Tile(3676, 3871, 0), {608, 16}}, // mushroom meadow
@@ -12,6 +12,12 @@ public:
   trapdoor(Tile object_tile, Tile destination)
       : obstacle(destination), object_tile(object_tile) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::trapdoor; }
+
+  void prepare() const override {
+    detail::approach_object(GroundObjects::Get(object_tile));
+  }
+
   bool handle() const override {
     auto obj = GroundObjects::Get(object_tile);
     if (!obj)
@@ -27,7 +33,7 @@ public:
       if (!obj.Interact("Open"))
         return false;
 
-      if (!WaitFunc(2000, 50, [&]() {
+      if (!obstacle_timing.wait(0, 2000, [&]() {
             obj = GroundObjects::Get(object_tile);
             return obj && obj.GetID() == open_id;
           }))
@@ -40,8 +46,8 @@ public:
     if (!obj.Interact("Climb-down"))
       return false;
 
-    return WaitFunc(2500, 50,
-                    [&]() { return Minimap::GetPosition() == destination; });
+    return obstacle_timing.wait(
+        1, 2500, [&]() { return tick::player().position == destination; });
   }
 };
 } // namespace as::web_walker::obstacles
\ No newline at end of file
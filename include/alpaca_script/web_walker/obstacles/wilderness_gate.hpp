@@ -11,6 +11,18 @@ public:
   wilderness_gate(Tile closed_position, Tile destination)
       : obstacle(destination), closed_position(closed_position) {}
 
+  obstacle_kind kind() const override { return obstacle_kind::wilderness_gate; }
+
+  obstacle_requirements requirements() const override {
+    obstacle_requirements result;
+    result.wilderness = true;
+    return result;
+  }
+
+  void prepare() const override {
+    detail::approach_object(WallObjects::Get(closed_position));
+  }
+
   bool handle() const override {
     const auto gate = WallObjects::Get(closed_position);
     if (!gate)
@@ -19,8 +31,8 @@ public:
     if (!gate.Interact("Open"))
       return false;
 
-    WaitFunc(2000, 50, [&]() {
-      if (Minimap::GetPosition() == destination)
+    tick::wait(2000, [&]() {
+      if (tick::player().position == destination)
         return true;
 
       const auto widget = Widgets::Get(475, 11);
@@ -30,12 +42,12 @@ public:
       if (!widget.Interact())
         return false;
 
-      return WaitFunc(2000, 50,
-                      [&]() { return Minimap::GetPosition() == destination; });
+      return obstacle_timing.wait(
+          0, 2000, [&]() { return tick::player().position == destination; });
     });
 
-    return WaitFunc(3000, 50,
-                    [&]() { return Minimap::GetPosition() == destination; });
+    return obstacle_timing.wait(
+        1, 3000, [&]() { return tick::player().position == destination; });
   }
 };
 } // namespace as::web_walker::obstacles
\ No newline at end of file
@@ -1,11 +1,19 @@
 #pragma once
 
+#include <algorithm>
+#include <initializer_list>
+#include <memory_resource>
+#include <optional>
 #include <variant>
+#include <vector>
 #include <Game/Tools/Pathfinding.hpp>
+#include "local_reachability.hpp"
 #include "obstacle.hpp"
 #include "teleport.hpp"
 
 namespace as::web_walker {
+// Steps of a path. The steps and the index use a polymorphic allocator, so a
+// path can live in a caller provided memory_resource.
 class path {
 public:
   using obstacle_step = std::pair<Tile, const obstacle *>;
@@ -14,90 +22,133 @@ public:
 
   using value_type = std::variant<Tile, obstacle_step, teleport_step>;
 
-  using reference = value_type &;
+  using reference = const value_type &;
 
-  using vector = std::vector<value_type>;
+  using vector = std::pmr::vector<value_type>;
 
-  using iterator = vector::iterator;
+  using allocator_type = vector::allocator_type;
 
-  using const_iterator = vector::const_iterator;
+  // Steps are only changed through the members below, which keep the
+  // obstacle and teleport index in sync, so iterators are always const.
+  using iterator = vector::const_iterator;
 
-  vector steps;
+  using const_iterator = vector::const_iterator;
 
   path() = default;
 
-  path(const path &other) : steps(other.steps) {}
+  explicit path(const allocator_type &alloc)
+      : _steps(alloc), _obstacles(alloc), _teleports(alloc) {}
+
+  path(const path &other)
+      : _steps(other._steps), _obstacles(other._obstacles),
+        _teleports(other._teleports) {}
 
-  path(path &&other) : steps(std::move(other.steps)) {}
+  path(const path &other, const allocator_type &alloc)
+      : _steps(other._steps, alloc), _obstacles(other._obstacles, alloc),
+        _teleports(other._teleports, alloc) {}
 
-  path(const vector &steps) : steps(steps) {}
+  path(path &&other)
+      : _steps(std::move(other._steps)),
+        _obstacles(std::move(other._obstacles)),
+        _teleports(std::move(other._teleports)) {}
 
-  path(vector &&steps) : steps(std::move(steps)) {}
+  path(const vector &steps)
+      : _steps(steps), _obstacles(_steps.get_allocator()),
+        _teleports(_steps.get_allocator()) {
+    _reindex();
+  }
+
+  path(vector &&steps)
+      : _steps(std::move(steps)), _obstacles(_steps.get_allocator()),
+        _teleports(_steps.get_allocator()) {
+    _reindex();
+  }
+
+  path(std::initializer_list<value_type> steps)
+      : _steps(steps), _obstacles(_steps.get_allocator()),
+        _teleports(_steps.get_allocator()) {
+    _reindex();
+  }
+
+  // steps built in a plain std::vector, copied into alloc
+  path(const std::vector<value_type> &steps,
+       const allocator_type &alloc = allocator_type())
+      : _steps(steps.begin(), steps.end(), alloc), _obstacles(alloc),
+        _teleports(alloc) {
+    _reindex();
+  }
 
   path &operator=(const path &other) {
-    steps = other.steps;
+    _steps = other._steps;
+    _obstacles = other._obstacles;
+    _teleports = other._teleports;
     return *this;
   }
 
   path &operator=(path &&other) {
-    steps = std::move(other.steps);
+    _steps = std::move(other._steps);
+    _obstacles = std::move(other._obstacles);
+    _teleports = std::move(other._teleports);
     return *this;
   }
 
-  iterator insert(const iterator &pos, const value_type &value) {
-    return steps.insert(pos, value);
+  iterator insert(const_iterator pos, const value_type &value) {
+    const auto index = static_cast<std::size_t>(pos - _steps.begin());
+    auto it = _steps.insert(pos, value);
+    _index_inserted(index);
+    return it;
   }
 
-  iterator insert(const iterator &pos, value_type &&value) {
-    return steps.insert(pos, std::move(value));
+  iterator insert(const_iterator pos, value_type &&value) {
+    const auto index = static_cast<std::size_t>(pos - _steps.begin());
+    auto it = _steps.insert(pos, std::move(value));
+    _index_inserted(index);
+    return it;
   }
 
   template <typename... Args> reference emplace_back(Args &&...args) {
-    return steps.emplace_back(std::forward<Args &&>(args)...);
+    auto &result = _steps.emplace_back(std::forward<Args &&>(args)...);
+    _index_step(_steps.size() - 1);
+    return result;
   }
 
-  iterator begin() { return steps.begin(); }
+  // replaces every step
+  void assign(vector steps) {
+    _steps = std::move(steps);
+    _reindex();
+  }
 
-  iterator end() { return steps.end(); }
+  void clear() {
+    _steps.clear();
+    _obstacles.clear();
+    _teleports.clear();
+  }
 
-  const_iterator begin() const { return steps.begin(); }
+  allocator_type get_allocator() const { return _steps.get_allocator(); }
 
-  const_iterator end() const { return steps.end(); }
+  const vector &steps() const { return _steps; }
 
-  reference front() { return steps.front(); }
+  // positions of the obstacle steps, in ascending order
+  const std::pmr::vector<std::size_t> &obstacle_positions() const {
+    return _obstacles;
+  }
 
-  reference back() { return steps.back(); }
+  // positions of the teleport steps, in ascending order
+  const std::pmr::vector<std::size_t> &teleport_positions() const {
+    return _teleports;
+  }
 
-  auto &front() const { return steps.front(); }
+  std::size_t size() const { return _steps.size(); }
 
-  auto &back() const { return steps.back(); }
+  bool empty() const { return _steps.empty(); }
 
-  static iterator
-  closest(iterator it, iterator end, const Tile &tile,
-          std::int32_t distance = std::numeric_limits<std::int32_t>::max()) {
-    iterator closest = end;
-    for (; it != end; ++it) {
-      if (auto current_tile = std::get_if<Tile>(&*it)) {
-        if (current_tile->Plane != tile.Plane)
-          continue;
+  const_iterator begin() const { return _steps.begin(); }
 
-        auto dist = current_tile->DistanceFrom(tile);
+  const_iterator end() const { return _steps.end(); }
 
-        if (dist <= distance) {
-          closest = it;
-          distance = dist;
-        }
-      }
-    }
-
-    return closest;
-  }
+  reference front() const { return _steps.front(); }
 
-  iterator
-  closest(const Tile &tile,
-          std::int32_t distance = std::numeric_limits<std::int32_t>::max()) {
-    return closest(begin(), end(), tile, distance);
-  }
+  reference back() const { return _steps.back(); }
 
   static const_iterator
   closest(const_iterator it, const_iterator end, const Tile &tile,
@@ -126,33 +177,6 @@ public:
     return closest(this->begin(), this->end(), tile, distance);
   }
 
-  static iterator
-  furthest(iterator it, iterator end, const Tile &tile,
-           std::int32_t distance = std::numeric_limits<std::int32_t>::min()) {
-    iterator furthest = end;
-    // return furthest tile within the given distance
-    for (; it != end; ++it) {
-      if (auto current_tile = std::get_if<Tile>(&*it)) {
-        if (current_tile->Plane != tile.Plane)
-          continue;
-
-        auto dist = current_tile->DistanceFrom(tile);
-        if (dist >= distance)
-          continue;
-
-        furthest = it;
-      }
-    }
-
-    return furthest;
-  }
-
-  iterator
-  furthest(const Tile &tile,
-           std::int32_t distance = std::numeric_limits<std::int32_t>::min()) {
-    return furthest(begin(), end(), tile, distance);
-  }
-
   static const_iterator
   furthest(const_iterator it, const_iterator end, const Tile &tile,
            std::int32_t distance = std::numeric_limits<std::int32_t>::min()) {
@@ -180,13 +204,14 @@ public:
     return furthest(this->begin(), this->end(), tile, distance);
   }
 
-  static iterator furthest_reachable(iterator it, iterator end,
-                                     const Tile &tile,
-                                     std::int32_t distance = 0) {
-    iterator furthest = end;
+  static const_iterator furthest_reachable(const_iterator it,
+                                           const_iterator end,
+                                           const Tile &tile,
+                                           std::int32_t distance = 0) {
+    const_iterator furthest = end;
 
-    auto is_reachable = [](const Tile& t) {
-      return !Pathfinding::FindPathTo(t).empty();
+    auto is_reachable = [&](const Tile &t) {
+      return reachability.reachable(tile, t);
     };
 
     for (; it != end; ++it) {
@@ -208,34 +233,123 @@ public:
     return furthest;
   }
 
-  std::pair<iterator, obstacle_step *> next_obstacle(iterator it,
-                                                     iterator end) {
+  // Same result as furthest_reachable when the tiles from it on are reachable
+  // up to a first break, as they are when it is the player's place on the
+  // path. Gallops forward over the tiles passing the plane and distance filter
+  // and then bisects, so it makes O(log n) reachability checks. Returns the
+  // furthest tile and the number of checks made.
+  template <typename Iterator>
+  static std::pair<Iterator, std::size_t> furthest_reachable_search(
+      Iterator it, Iterator end, const Tile &tile,
+      std::int32_t distance = std::numeric_limits<std::int32_t>::max()) {
+    std::vector<Iterator> candidates;
     for (; it != end; ++it) {
-      if (obstacle_step *step = std::get_if<obstacle_step>(&*it)) {
-        return {it, step};
+      auto current_tile = std::get_if<Tile>(&*it);
+      if (current_tile && current_tile->Plane == tile.Plane &&
+          current_tile->DistanceFrom(tile) < distance)
+        candidates.push_back(it);
+    }
+
+    std::size_t checks = 0;
+    const auto is_reachable = [&](std::size_t i) {
+      ++checks;
+      return reachability.reachable(tile, std::get<Tile>(*candidates[i]));
+    };
+
+    // candidates up to lo are reachable, the ones from hi on are not
+    std::ptrdiff_t lo = -1;
+    auto hi = static_cast<std::ptrdiff_t>(candidates.size());
+
+    for (std::ptrdiff_t step = 1; lo + step < hi; step *= 2) {
+      if (!is_reachable(lo + step)) {
+        hi = lo + step;
+        break;
       }
+
+      lo += step;
     }
 
-    return {end, nullptr};
-  }
+    while (hi - lo > 1) {
+      const auto mid = lo + (hi - lo) / 2;
+      if (is_reachable(mid))
+        lo = mid;
+      else
+        hi = mid;
+    }
 
-  std::pair<iterator, obstacle_step *> next_obstacle() {
-    return next_obstacle(begin(), end());
+    return {lo < 0 ? end : candidates[lo], checks};
   }
 
   std::pair<const_iterator, const obstacle_step *>
   next_obstacle(const_iterator it, const_iterator end) const {
-    for (; it != end; ++it) {
-      if (const obstacle_step *step = std::get_if<obstacle_step>(&*it)) {
-        return {it, step};
-      }
-    }
+    auto next = _next(_obstacles, it - begin(), end - begin());
+    if (!next)
+      return {end, nullptr};
 
-    return {end, nullptr};
+    it = begin() + *next;
+    return {it, std::get_if<obstacle_step>(&*it)};
   }
 
   std::pair<const_iterator, const obstacle_step *> next_obstacle() const {
     return next_obstacle(begin(), end());
   }
+
+  std::pair<const_iterator, const teleport_step *>
+  next_teleport(const_iterator it, const_iterator end) const {
+    auto next = _next(_teleports, it - begin(), end - begin());
+    if (!next)
+      return {end, nullptr};
+
+    it = begin() + *next;
+    return {it, std::get_if<teleport_step>(&*it)};
+  }
+
+  std::pair<const_iterator, const teleport_step *> next_teleport() const {
+    return next_teleport(begin(), end());
+  }
+
+private:
+  vector _steps;
+  std::pmr::vector<std::size_t> _obstacles;
+  std::pmr::vector<std::size_t> _teleports;
+
+  void _reindex() {
+    _obstacles.clear();
+    _teleports.clear();
+    for (std::size_t i = 0; i < _steps.size(); ++i)
+      _index_step(i);
+  }
+
+  void _index_step(std::size_t index) {
+    if (std::holds_alternative<obstacle_step>(_steps[index]))
+      _obstacles.insert(
+          std::upper_bound(_obstacles.begin(), _obstacles.end(), index), index);
+    else if (std::holds_alternative<teleport_step>(_steps[index]))
+      _teleports.insert(
+          std::upper_bound(_teleports.begin(), _teleports.end(), index), index);
+  }
+
+  void _index_inserted(std::size_t index) {
+    for (auto *positions : {&_obstacles, &_teleports}) {
+      for (auto it = std::lower_bound(positions->begin(), positions->end(),
+                                      index);
+           it != positions->end(); ++it)
+        ++*it;
+    }
+
+    _index_step(index);
+  }
+
+  // first indexed position in [first, last)
+  static std::optional<std::size_t>
+  _next(const std::pmr::vector<std::size_t> &positions, std::ptrdiff_t first,
+        std::ptrdiff_t last) {
+    auto it = std::lower_bound(positions.begin(), positions.end(),
+                               static_cast<std::size_t>(first));
+    if (it == positions.end() || *it >= static_cast<std::size_t>(last))
+      return std::nullopt;
+
+    return *it;
+  }
 };
 } // namespace as::web_walker
\ No newline at end of file
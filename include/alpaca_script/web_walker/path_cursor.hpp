@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "path.hpp"
+#include "tile_key.hpp"
+
+namespace as::web_walker {
+// Tracks the walker's progress along a path. Lookups search forward from the
+// last match, and only fall back to a coarse grid index of the path tiles
+// when the player has wandered off the path.
+class path_cursor {
+public:
+  using const_iterator = path::const_iterator;
+
+  // path steps searched around the last match before using the grid index
+  static constexpr std::size_t window = 32;
+
+  // a match this close to the player is accepted without using the index
+  static constexpr std::int32_t on_path_distance = 2;
+
+  // side length of a grid bucket, in tiles
+  static constexpr std::int32_t bucket_size = 8;
+
+  path_cursor(const path &p) : _path(&p) {
+    for (std::size_t i = 0; i < p.steps().size(); ++i) {
+      if (auto tile = std::get_if<Tile>(&p.steps()[i]))
+        _buckets[_bucket(tile->X, tile->Y, tile->Plane)].push_back(i);
+    }
+  }
+
+  const_iterator position() const {
+    return _matched ? std::next(_path->begin(), _index) : _path->end();
+  }
+
+  // Closest path tile to tile within the given distance, preferring the
+  // steps just ahead of the last match.
+  const_iterator
+  update(const Tile &tile,
+         std::int32_t distance = std::numeric_limits<std::int32_t>::max()) {
+    const auto &steps = _path->steps();
+
+    if (_matched) {
+      auto best = steps.size();
+      auto best_dist = distance;
+
+      const auto back = static_cast<std::size_t>(on_path_distance);
+      const auto from = _index > back ? _index - back : std::size_t(0);
+      const auto to = std::min(_index + window, steps.size());
+      for (auto i = from; i < to; ++i) {
+        auto current_tile = std::get_if<Tile>(&steps[i]);
+        if (!current_tile || current_tile->Plane != tile.Plane)
+          continue;
+
+        auto dist = current_tile->DistanceFrom(tile);
+        if (dist < best_dist) {
+          best = i;
+          best_dist = dist;
+        }
+      }
+
+      if (best != steps.size() && best_dist <= on_path_distance) {
+        _index = best;
+        return std::next(_path->begin(), _index);
+      }
+    }
+
+    auto closest = _lookup(tile, distance);
+    _matched = closest != _path->end();
+    if (_matched)
+      _index = std::distance(_path->begin(), closest);
+
+    return closest;
+  }
+
+  // Furthest path tile between the cursor and end within the given distance.
+  // The scan stops once window steps in a row have been out of range.
+  const_iterator furthest(const_iterator end, const Tile &tile,
+                          std::int32_t distance) const {
+    auto furthest = end;
+    std::size_t misses = 0;
+
+    for (auto it = position(); it != end && misses < window; ++it) {
+      auto current_tile = std::get_if<Tile>(&*it);
+      if (!current_tile || current_tile->Plane != tile.Plane ||
+          current_tile->DistanceFrom(tile) >= distance) {
+        ++misses;
+        continue;
+      }
+
+      furthest = it;
+      misses = 0;
+    }
+
+    return furthest;
+  }
+
+  // Next obstacle at or after the cursor.
+  std::pair<const_iterator, const path::obstacle_step *> next_obstacle() const {
+    return _path->next_obstacle(position(), _path->end());
+  }
+
+private:
+  const path *_path;
+  std::size_t _index = 0;
+  bool _matched = false;
+
+  std::unordered_map<std::uint32_t, std::vector<std::size_t>> _buckets;
+
+  static std::uint32_t _bucket(std::int32_t x, std::int32_t y,
+                               std::int32_t plane) {
+    return tile_key(Tile(x / bucket_size, y / bucket_size, plane)).value;
+  }
+
+  const_iterator _lookup(const Tile &tile, std::int32_t distance) const {
+    // the grid only pays off for a bounded search radius
+    constexpr std::int32_t max_radius = 16 * bucket_size;
+    if (distance > max_radius)
+      return _path->closest(tile, distance);
+
+    auto best = _path->size();
+    auto best_dist = distance;
+
+    for (auto bx = (tile.X - distance) / bucket_size;
+         bx <= (tile.X + distance) / bucket_size; ++bx) {
+      for (auto by = (tile.Y - distance) / bucket_size;
+           by <= (tile.Y + distance) / bucket_size; ++by) {
+        auto bucket = _buckets.find(
+            _bucket(bx * bucket_size, by * bucket_size, tile.Plane));
+        if (bucket == _buckets.end())
+          continue;
+
+        for (auto i : bucket->second) {
+          auto dist = std::get<Tile>(_path->steps()[i]).DistanceFrom(tile);
+          if (dist < best_dist ||
+              (best != _path->size() && dist == best_dist && i < best)) {
+            best = i;
+            best_dist = dist;
+          }
+        }
+      }
+    }
+
+    return std::next(_path->begin(), best);
+  }
+};
+} // namespace as::web_walker
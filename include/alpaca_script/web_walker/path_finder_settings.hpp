@@ -16,10 +16,42 @@ namespace as::web_walker {
     std::int32_t strength_level = 1;
 
     bool use_transportations = true;
+    bool use_wilderness = true;
+
+    // quest and item requirements the player meets, one bit each, see
+    // obstacle_requirements::flags
+    std::uint64_t unlocked = 0;
 
     std::vector<item> items = {};
     
     path_finder_settings() = default;
+
+    // FNV-1a over every setting, stable across runs
+    std::uint64_t hash() const {
+      std::uint64_t result = 14695981039346656037ULL;
+      const auto combine = [&](std::uint64_t value) {
+        result = (result ^ value) * 1099511628211ULL;
+      };
+
+      combine(use_shortcuts);
+      combine(use_teleport);
+      combine(agility_level);
+      combine(magic_level);
+      combine(ranged_level);
+      combine(strength_level);
+      combine(use_transportations);
+      combine(use_wilderness);
+      combine(unlocked);
+
+      for (const auto &[name, count] : items) {
+        for (auto c : name)
+          combine(static_cast<unsigned char>(c));
+
+        combine(count);
+      }
+
+      return result;
+    }
   };
 
   path_finder_settings get_player_settings() {
@@ -1,30 +1,29 @@
 #pragma once
 
-#include <queue>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <optional>
 #include <stdexcept>
-#include <unordered_set>
 
 #include <alpaca_script/mouse_camera.hpp>
+#include <alpaca_script/tick.hpp>
 
+#include "bucket_queue.hpp"
 #include "collision.hpp"
+#include "line_of_sight.hpp"
 #include "obstacle.hpp"
+#include "obstacle_edge.hpp"
 #include "obstacles.hpp"
 #include "path.hpp"
+#include "path_cursor.hpp"
 #include "path_finder_settings.hpp"
+#include "route_library.hpp"
+#include "search_context.hpp"
+#include "tile_key.hpp"
+#include "walk_settings.hpp"
 
 namespace as::web_walker {
-class path_node {
-public:
-  path::value_type value;
-  std::shared_ptr<path_node> parent;
-
-  path_node(const path::value_type &value, std::shared_ptr<path_node> parent)
-      : value(value), parent(parent) {}
-
-  path_node(path::value_type &&value, std::shared_ptr<path_node> parent)
-      : value(std::move(value)), parent(parent) {}
-};
-
 std::vector<path::value_type> get_neighbors(const Tile &tile) {
   std::vector<path::value_type> result;
 
@@ -42,23 +41,13 @@ std::vector<path::value_type> get_neighbors(const Tile &tile) {
   return result;
 }
 
-bool blocked(std::int32_t flags) {
-  return (flags & Pathfinding::BLOCKED) || (flags & Pathfinding::OCCUPIED);
-}
-
-std::int32_t is_collision(const Tile &tile) {
-  auto flags = collision_map.find(tile);
-  if (flags != collision_map.end()) {
-    return flags->second;
-  }
-
-  return 0;
-}
+// an obstacle entered from the tile, as seen by the search
+using edge_step = std::pair<Tile, const obstacle_edge *>;
 
+// Calls func with every walkable neighbouring Tile and with an edge_step for
+// every obstacle entered from a neighbour.
 void visit_neighbors(const Tile &tile, auto &&func) {
-  // return ((std::int32_t) (((MyPos.X >> 6) << 8) | (MyPos.Y >> 6)));
-  auto region = ((tile.X >> 6) << 8) | (tile.Y >> 6);
-  if (mapped_regions.find(region) == mapped_regions.end()) {
+  if (!is_mapped(tile)) {
     return;
   }
 
@@ -67,10 +56,10 @@ void visit_neighbors(const Tile &tile, auto &&func) {
   if (!(flags & Pathfinding::NORTH)) {
     auto north = tile + Tile(0, 1, 0);
 
-    auto obstacles = obstacle_map.equal_range(north);
-    if (obstacles.first != obstacle_map.end()) {
-      for (auto it = obstacles.first; it != obstacles.second; ++it) {
-        func(path::obstacle_step(north, it->second.get()));
+    auto edges = obstacle_map.edges(north);
+    if (edges.first != edges.second) {
+      for (auto edge = edges.first; edge != edges.second; ++edge) {
+        func(edge_step(north, edge));
       }
     } else {
       if (!blocked(is_collision(north))) {
@@ -83,10 +72,10 @@ void visit_neighbors(const Tile &tile, auto &&func) {
   if (!(flags & Pathfinding::EAST)) {
     auto east = tile + Tile(1, 0, 0);
 
-    auto obstacles = obstacle_map.equal_range(east);
-    if (obstacles.first != obstacle_map.end()) {
-      for (auto it = obstacles.first; it != obstacles.second; ++it) {
-        func(path::obstacle_step(east, it->second.get()));
+    auto edges = obstacle_map.edges(east);
+    if (edges.first != edges.second) {
+      for (auto edge = edges.first; edge != edges.second; ++edge) {
+        func(edge_step(east, edge));
       }
     } else {
       if (!blocked(is_collision(east))) {
@@ -99,10 +88,10 @@ void visit_neighbors(const Tile &tile, auto &&func) {
   if (!(flags & Pathfinding::SOUTH)) {
     auto south = tile + Tile(0, -1, 0);
 
-    auto obstacles = obstacle_map.equal_range(south);
-    if (obstacles.first != obstacle_map.end()) {
-      for (auto it = obstacles.first; it != obstacles.second; ++it) {
-        func(path::obstacle_step(south, it->second.get()));
+    auto edges = obstacle_map.edges(south);
+    if (edges.first != edges.second) {
+      for (auto edge = edges.first; edge != edges.second; ++edge) {
+        func(edge_step(south, edge));
       }
     } else {
       if (!blocked(is_collision(south))) {
@@ -115,10 +104,10 @@ void visit_neighbors(const Tile &tile, auto &&func) {
   if (!(flags & Pathfinding::WEST)) {
     auto west = tile + Tile(-1, 0, 0);
 
-    auto obstacles = obstacle_map.equal_range(west);
-    if (obstacles.first != obstacle_map.end()) {
-      for (auto it = obstacles.first; it != obstacles.second; ++it) {
-        func(path::obstacle_step(west, it->second.get()));
+    auto edges = obstacle_map.edges(west);
+    if (edges.first != edges.second) {
+      for (auto edge = edges.first; edge != edges.second; ++edge) {
+        func(edge_step(west, edge));
       }
     } else {
       if (!blocked(is_collision(west))) {
@@ -128,70 +117,70 @@ void visit_neighbors(const Tile &tile, auto &&func) {
   }
 }
 
-path find_path(const Tile &start, const Tile &dest,
-               const path_finder_settings &settings = get_player_settings()) {
+// cost of every step of a search, walking one tile or passing an obstacle
+constexpr std::uint32_t tile_cost = 1;
+
+// Search from start to the nearest tile accepted by is_goal. Every step costs
+// tile_cost, so this is a breadth first search; the bucket_queue frontier
+// pops the steps in the order they were found. All scratch space
+// lives in the search_context and is reused by the next search. There is no
+// A* heuristic, as teleports and obstacles into dungeons make the coordinate
+// distance a bad estimate.
+path find_path_if(const Tile &start, auto &&is_goal,
+                  const path_finder_settings &settings,
+                  search_context &context = search_context::local()) {
+  context.clear();
 
-  std::queue<std::shared_ptr<path_node>> queue;
-  std::unordered_set<Tile> visited;
+  const auto relax = [&](const tile_key &tile, std::uint32_t cost,
+                         const path::value_type &value, std::uint32_t parent) {
+    if (context.costs.lower(tile, cost))
+      context.frontier.push(cost, context.add_node(value, parent));
+  };
 
-  queue.emplace(std::make_shared<path_node>(start, nullptr));
+  relax(start, 0, start, search_context::no_parent);
 
   auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(10);
 
-  while (!queue.empty()) {
+  while (!context.frontier.empty()) {
     if (std::chrono::steady_clock::now() > end_time) {
       throw std::runtime_error("timeout");
     }
 
-    auto current = std::move(queue.front());
-    queue.pop();
+    const auto [cost, current] = context.frontier.pop();
 
-    if (auto tile = std::get_if<Tile>(&current->value)) {
-      if (*tile == dest) {
-        path result;
+    const auto &value = context.nodes[current].value;
+    const auto obs = std::get_if<path::obstacle_step>(&value);
+    const auto tile = obs ? obs->second->destination : std::get<Tile>(value);
 
-        while (current != nullptr) {
-          result.emplace_back(current->value);
-          current = current->parent;
-        }
+    // a cheaper way to this tile was found after this node was queued
+    if (*context.costs.find(tile) < cost)
+      continue;
 
-        std::reverse(result.begin(), result.end());
-        return result;
-      }
-    }
+    if (is_goal(tile)) {
+      const auto &trace = context.trace(current);
 
-    auto tile = std::visit(
-        [&](auto &&value) {
-          using value_t = std::decay_t<decltype(value)>;
-          if constexpr (std::is_same_v<value_t, Tile>) {
-            return value;
-          } else if constexpr (std::is_same_v<value_t, path::obstacle_step>) {
-            return value.second->destination;
-          }
+      // the path always ends on a tile, also when an obstacle leads there
+      path::vector steps(context.resource());
+      steps.reserve(trace.size() + 1);
+      steps.assign(trace.begin(), trace.end());
+      if (obs)
+        steps.emplace_back(tile);
 
-          throw std::runtime_error("unexpected value type");
-          return Tile();
-        },
-        current->value);
+      return path(std::move(steps));
+    }
 
     visit_neighbors(tile, [&](auto &&neighbor) {
       using neighbor_t = std::decay_t<decltype(neighbor)>;
 
       if constexpr (std::is_same_v<neighbor_t, Tile>) {
-        if (visited.find(neighbor) != visited.end())
-          return;
-
-        queue.emplace(std::make_shared<path_node>(neighbor, current));
-        visited.insert(neighbor);
-      } else if constexpr (std::is_same_v<neighbor_t, path::obstacle_step>) {
-        if (visited.find(neighbor.second->destination) != visited.end())
+        relax(neighbor, cost + tile_cost, neighbor, current);
+      } else if constexpr (std::is_same_v<neighbor_t, edge_step>) {
+        const auto &edge = *neighbor.second;
+        if (!edge.can_handle(settings))
           return;
 
-        if (!neighbor.second->can_handle(settings))
-          return;
-
-        queue.emplace(std::make_shared<path_node>(neighbor, current));
-        visited.insert(neighbor.second->destination);
+        relax(edge.destination, cost + tile_cost,
+              path::obstacle_step(neighbor.first, edge.handler), current);
       }
     });
   }
@@ -199,6 +188,129 @@ path find_path(const Tile &start, const Tile &dest,
   throw std::runtime_error("no path found");
 }
 
+// furthest ring searched for a walkable tile around a blocked destination
+constexpr std::int32_t snap_radius = 5;
+
+// Walkable tiles on the nearest ring around dest that has any. On the first
+// ring only the tiles that face dest without a wall in between are used, so
+// the player can interact with what stands on dest. When start is close
+// enough for a local search, tiles it cannot reach are left out too, so a
+// tile behind a wall or counter is not picked.
+std::vector<Tile> snap_candidates(const Tile &dest, const Tile &start) {
+  std::vector<Tile> result;
+
+  auto &local = local_reachability::local();
+  const auto usable = [&](const Tile &tile) {
+    if (!is_mapped(tile) || blocked(is_collision(tile)))
+      return false;
+
+    const auto in_range =
+        tile.Plane == start.Plane &&
+        std::abs(tile.X - start.X) <= local_reachability::radius &&
+        std::abs(tile.Y - start.Y) <= local_reachability::radius;
+    return !in_range || local.reachable(start, tile);
+  };
+
+  const std::pair<Tile, std::int32_t> adjacent[4] = {
+      {Tile(0, -1, 0), Pathfinding::NORTH},
+      {Tile(-1, 0, 0), Pathfinding::EAST},
+      {Tile(0, 1, 0), Pathfinding::SOUTH},
+      {Tile(1, 0, 0), Pathfinding::WEST}};
+
+  for (const auto &[offset, flag] : adjacent) {
+    const auto tile = dest + offset;
+    if (usable(tile) && !(is_collision(tile) & flag))
+      result.push_back(tile);
+  }
+
+  for (std::int32_t r = 2; r <= snap_radius && result.empty(); ++r) {
+    for (auto dx = -r; dx <= r; ++dx) {
+      for (auto dy = -r; dy <= r; ++dy) {
+        if (std::abs(dx) != r && std::abs(dy) != r)
+          continue;
+
+        const auto tile = dest + Tile(dx, dy, 0);
+        if (usable(tile))
+          result.push_back(tile);
+      }
+    }
+  }
+
+  return result;
+}
+
+// Path to dest. A blocked dest, like a bank booth, is snapped to the nearest
+// ring of walkable and reachable tiles around it, and the path ends on the
+// first of those the search reaches. A route to dest's area in the routes
+// library is used instead of searching, finished with a short search to dest
+// when dest is locally reachable from its end; paths are only stored there
+// by callers that call routes.store themselves.
+path find_path(const Tile &start, const Tile &dest,
+               const path_finder_settings &settings = get_player_settings(),
+               search_context &context = search_context::local()) {
+  const auto snapped = is_mapped(dest) && blocked(is_collision(dest));
+
+  std::vector<Tile> goals;
+  if (snapped) {
+    goals = snap_candidates(dest, start);
+    if (goals.empty())
+      throw std::runtime_error("destination is blocked");
+  }
+
+  const auto is_goal = [&](const Tile &tile) {
+    if (!snapped)
+      return tile == dest;
+
+    return std::find(goals.begin(), goals.end(), tile) != goals.end();
+  };
+
+  if (auto route = routes.find(start, dest, settings)) {
+    const auto end = std::get<Tile>(route->back());
+    if (is_goal(end))
+      return std::move(*route);
+
+    auto &local = local_reachability::local();
+    const auto reachable = [&](const Tile &goal) {
+      return local.reachable(end, goal);
+    };
+
+    if (snapped ? std::any_of(goals.begin(), goals.end(), reachable)
+                : reachable(dest)) {
+      const auto rest = find_path_if(end, is_goal, settings, context);
+      for (auto it = std::next(rest.begin()); it != rest.end(); ++it)
+        route->emplace_back(*it);
+
+      return std::move(*route);
+    }
+  }
+
+  return find_path_if(start, is_goal, settings, context);
+}
+
+// Path to the nearest tile in the area. Blocked tiles of the area are never
+// reached, so there is no snapping; an area with no walkable tile fails.
+path find_path(const Tile &start, const Area &area,
+               const path_finder_settings &settings = get_player_settings(),
+               search_context &context = search_context::local()) {
+  return find_path_if(
+      start, [&](const Tile &tile) { return area.Contains(tile); }, settings,
+      context);
+}
+
+// Path to the nearest tile within radius of dest, on the same plane. Like the
+// area overload this does not snap, a blocked dest is fine as long as a tile
+// within radius is walkable.
+path find_path(const Tile &start, const Tile &dest, std::int32_t radius,
+               const path_finder_settings &settings = get_player_settings(),
+               search_context &context = search_context::local()) {
+  return find_path_if(
+      start,
+      [&](const Tile &tile) {
+        return tile.Plane == dest.Plane && tile.DistanceFrom(dest) <= radius;
+      },
+      settings, context);
+}
+
 // bool walk_path(const path &path, std::int32_t distance, const auto predicate)
 // {
 //   if (!Mainscreen::IsLoggedIn())
@@ -315,37 +427,294 @@ path find_path(const Tile &start, const Tile &dest,
 //   return true;
 // }
 
-bool walk_path(const path &path, std::int32_t distance, const auto predicate) {
+// maximum distance of a straight line click ahead of the player
+constexpr std::int32_t line_of_sight_distance = 16;
+
+// live wall objects near the tile also checked for on a stall
+constexpr std::int32_t stall_wall_radius = 3;
+
+// a stall costs an attempt after this many in a row without progress
+constexpr std::int32_t max_free_replans = 3;
+
+// Doors and gates near the tile that are closed right now, whatever the
+// collision data says about them.
+std::vector<Interactable::GameObject> closed_walls_near(const Tile &tile,
+                                                        std::int32_t radius) {
+  return WallObjects::GetAll([&](const auto &obj) {
+    const auto at = obj.GetTile();
+    if (at.Plane != tile.Plane || at.DistanceFrom(tile) > radius)
+      return false;
+
+    const auto actions = obj.GetInfo().GetActions();
+    return std::find(actions.begin(), actions.end(), "Open") != actions.end();
+  });
+}
+
+// Collision flag of the wall on the side of tile facing next, the flag
+// local_reachability tests to step from tile to next. Zero when next is not
+// an orthogonal neighbour.
+std::int32_t wall_flag(const Tile &tile, const Tile &next) {
+  if (tile.Plane != next.Plane ||
+      std::abs(next.X - tile.X) + std::abs(next.Y - tile.Y) != 1)
+    return 0;
+
+  if (next.X > tile.X)
+    return Pathfinding::EAST;
+
+  if (next.X < tile.X)
+    return Pathfinding::WEST;
+
+  return next.Y > tile.Y ? Pathfinding::NORTH : Pathfinding::SOUTH;
+}
+
+// Opens the closest closed door or gate next to the tile, and returns the tile
+// of the opened wall.
+std::optional<Tile> open_wall_near(const Tile &tile) {
+  auto walls = closed_walls_near(tile, 1);
+  if (walls.empty())
+    return std::nullopt;
+
+  const auto &wall = *std::min_element(
+      walls.begin(), walls.end(), [&](const auto &a, const auto &b) {
+        return a.GetTile().DistanceFrom(tile) < b.GetTile().DistanceFrom(tile);
+      });
+
+  const auto at = wall.GetTile();
+  if (!wall.Interact("Open"))
+    return std::nullopt;
+
+  if (!tick::wait(2000, [&]() { return closed_walls_near(at, 0).empty(); }))
+    return std::nullopt;
+
+  return at;
+}
+
+// Clicks a tile to walk to the way the mode asks, only turning the camera when
+// the mainscreen has to be used.
+bool click_walk_tile(const Tile &tile, walk_mode mode) {
+  if (mode == walk_mode::automatic && Mainscreen::IsTileOn(tile))
+    return Mainscreen::ClickTile(tile);
+
+  if (mode != walk_mode::mainscreen && Minimap::IsTileOn(tile))
+    return Minimap::ClickTile(tile);
+
+  as::mouse_camera::set_pitch(360, 20, 15);
+
+  if (!Mainscreen::IsTileOn(tile)) {
+    if (!as::mouse_camera::rotate_to(tile, 20))
+      return false;
+  }
+
+  return Mainscreen::ClickTile(tile);
+}
+
+walk_result walk_path(const path &path, const walk_settings &settings,
+                      const auto predicate) {
+  using clock = std::chrono::steady_clock;
+
+  walk_result result;
+  const auto started = clock::now();
+  const auto end_tile = path.empty() ? Tile() : std::get<Tile>(path.back());
+
+  path_cursor cursor(path);
+  std::ptrdiff_t first_index = -1;
+
+  // the leg being walked, if any
+  std::optional<walk_result::leg> leg;
+  auto leg_started = started;
+  std::ptrdiff_t leg_index = 0;
+
+  const auto since = [](clock::time_point time) {
+    return std::chrono::duration_cast<walk_result::duration>(clock::now() -
+                                                             time);
+  };
+
+  const auto progress = [&]() {
+    const auto at = cursor.position();
+    return at == path.end() ? std::ptrdiff_t(-1) : at - path.begin();
+  };
+
+  const auto close_leg = [&]() {
+    if (!leg)
+      return;
+
+    leg->time = since(leg_started);
+    if (const auto index = progress(); index >= 0)
+      leg->tiles = static_cast<std::int32_t>(std::max(index - leg_index,
+                                                      std::ptrdiff_t(0)));
+
+    result.legs.push_back(*leg);
+    leg.reset();
+  };
+
+  // wall flags put into the reachability overlay on stalls, with the closed
+  // wall they stand for and the flags this walk added, so flags set by anyone
+  // else are left alone
+  class overlay_flag {
+  public:
+    Tile wall;
+    Tile tile;
+    std::int32_t flags;
+  };
+
+  std::vector<overlay_flag> overlaid;
+
+  const auto release = [&](const Tile &wall) {
+    std::erase_if(overlaid, [&](const auto &entry) {
+      if (entry.wall != wall)
+        return false;
+
+      reachability.remove(entry.tile, entry.flags);
+      return true;
+    });
+  };
+
+  // opens the closed wall next to the tile and takes it out of the overlay
+  const auto open_wall = [&](const Tile &tile) {
+    const auto opened = open_wall_near(tile);
+    if (opened)
+      release(*opened);
+
+    return opened.has_value();
+  };
+
+  const auto finish = [&](walk_status status) {
+    close_leg();
+
+    for (const auto &entry : overlaid)
+      reachability.remove(entry.tile, entry.flags);
+    overlaid.clear();
+
+    result.status = status;
+    result.time = since(started);
+    if (const auto index = progress(); index >= 0 && first_index >= 0)
+      result.tiles = static_cast<std::int32_t>(
+          std::max(index - first_index, std::ptrdiff_t(0)));
+
+    const auto position = Minimap::GetPosition();
+    if (!path.empty() && position && position.Plane == end_tile.Plane)
+      result.final_distance = position.DistanceFrom(end_tile);
+
+    if (settings.sink)
+      settings.sink(result);
+
+    return result;
+  };
+
+  if (path.empty())
+    return finish(walk_status::no_target);
+
   if (!Mainscreen::IsLoggedIn())
-    return false;
+    return finish(walk_status::logged_out);
+
+  // next click worked out while walking to the last one
+  auto planned = path.end();
+
+  // obstacle already prepared during the leg before it, cleared once it is
+  // handled or the walk replans, so a retry prepares it again
+  const path::obstacle_step *prepared = nullptr;
 
   std::int32_t attempts = 0;
-  while (attempts <= 5) {
+
+  stall_detector stall(settings.stall_ticks);
+  bool replan = false;
+  std::int32_t stalls_in_a_row = 0;
+  std::ptrdiff_t stall_index = -1;
+
+  // Closes the edge between two path tiles in the reachability overlay, from
+  // both sides, for the closed wall on it.
+  const auto close_edge = [&](const Tile &wall, const Tile &from,
+                              const Tile &to) {
+    for (const auto &[tile, next] :
+         {std::pair(from, to), std::pair(to, from)}) {
+      if (const auto added = reachability.add(tile, wall_flag(tile, next)))
+        overlaid.push_back(overlay_flag{wall, tile, added});
+    }
+  };
+
+  // Puts the closed walls the path crosses near the player into the
+  // reachability overlay and picks the next target around them, returns
+  // false once the stalls have used up the attempts. Only the path step into
+  // or out of the wall's tile is closed, the first one ahead of the player:
+  // the player stalls before a door on the near side of that tile, and on
+  // the tile itself before a door on its far side.
+  const auto on_stall = [&](const Tile &position) {
+    ++result.stalls;
+    planned = path.end();
+    prepared = nullptr;
+    replan = true;
+
+    for (const auto &wall : closed_walls_near(position, stall_wall_radius)) {
+      const auto at = wall.GetTile();
+
+      auto it = cursor.position();
+      for (std::size_t i = 0; i < path_cursor::window && it != path.end() &&
+                              std::next(it) != path.end();
+           ++i, ++it) {
+        const auto from = std::get_if<Tile>(&*it);
+        const auto to = std::get_if<Tile>(&*std::next(it));
+        if (!from || !to || (*from != at && *to != at))
+          continue;
+
+        close_edge(at, *from, *to);
+        break;
+      }
+    }
+
+    if (const auto index = progress(); index >= 0)
+      stall_index = index;
+
+    if (++stalls_in_a_row > max_free_replans)
+      ++attempts;
+
+    return attempts <= 5;
+  };
+
+  while (true) {
     if (!Mainscreen::IsLoggedIn())
-      return false;
+      return finish(walk_status::logged_out);
 
     if (predicate())
-      return true;
+      return finish(walk_status::stopped);
 
     auto player_pos = Minimap::GetPosition();
-    auto closest = path.closest(player_pos, 10);
+    auto closest = cursor.update(player_pos, 10);
     if (closest == path.end())
-      return false;
+      return finish(walk_status::off_path);
+
+    if (first_index < 0)
+      first_index = closest - path.begin();
 
-    auto end_tile = std::get<Tile>(path.back());
+    if (closest - path.begin() > stall_index)
+      stalls_in_a_row = 0;
 
-    if (player_pos.DistanceFrom(end_tile) <= distance &&
+    if (player_pos.DistanceFrom(end_tile) <= settings.distance &&
         player_pos.Plane == end_tile.Plane)
-      return true;
+      return finish(walk_status::arrived);
 
-    auto obstacle_iter = path.next_obstacle(closest, path.end());
+    auto obstacle_iter = cursor.next_obstacle();
     if (obstacle_iter.first != path.end()) {
       auto obs = obstacle_iter.second;
       if (obs->first.DistanceFrom(player_pos) <= 3) {
-        if (!obs->second->handle()) {
+        planned = path.end();
+        close_leg();
+
+        const auto handle_started = clock::now();
+        const auto passed = [&]() {
+          obstacle_timings::handling timing(
+              obstacle_timing, obstacle_id(obs->first, *obs->second));
+          return obs->second->handle();
+        }();
+        prepared = nullptr;
+        result.obstacles.push_back(walk_result::obstacle_pass{
+            obs->first, obs->second->destination, obs->second->kind(),
+            since(handle_started), passed});
+
+        if (!passed) {
+          ++result.obstacle_retries;
           attempts++;
           if (attempts > 5)
-            return false;
+            return finish(walk_status::obstacle_failed);
 
           Debug::Info << "Failed to handle obstacle, trying again.\n";
           continue;
@@ -356,77 +725,195 @@ bool walk_path(const path &path, std::int32_t distance, const auto predicate) {
       }
     }
 
-    // std::cout << "Here 1\n";
-    // Wait(1000);
-
     player_pos = Minimap::GetPosition();
     if (!player_pos)
       continue;
 
-    // std::cout << "Here 2\n";
-    // Wait(1000);
-
-    closest = path.closest(player_pos, 10);
+    closest = cursor.update(player_pos, 10);
     if (closest == path.end())
-      return false;
+      return finish(walk_status::off_path);
+
+    // prefer the furthest tile we can walk to in a straight line from the
+    // given tile, and fall back to the furthest tile within clicking distance
+    const auto next_target = [&](path::const_iterator from, const Tile &tile) {
+      auto horizon =
+          cursor.furthest(obstacle_iter.first, tile, line_of_sight_distance);
+      auto furthest = obstacle_iter.first;
+      if (horizon != obstacle_iter.first) {
+        furthest = furthest_in_sight(from, std::next(horizon), tile,
+                                     line_of_sight_distance);
+        if (furthest == std::next(horizon))
+          furthest = obstacle_iter.first;
+      }
+
+      if (furthest == obstacle_iter.first)
+        furthest = cursor.furthest(obstacle_iter.first, tile, 13);
+
+      return furthest;
+    };
 
-    // std::cout << "Here 3\n";
-    // Wait(1000);
-    auto furthest =
-        obstacle_iter.first == path.end()
-            ? path.furthest(closest, path.end(), player_pos, 13)
-            : path.furthest(closest, obstacle_iter.first, player_pos, 13);
+    auto furthest = path.end();
+    if (replan) {
+      // walk around the blockage to the furthest path tile still reachable
+      // with the closed walls in the overlay, or open the wall if there is
+      // no way around it
+      replan = false;
+      const auto around =
+          path::furthest_reachable_search(closest, obstacle_iter.first,
+                                          player_pos, line_of_sight_distance)
+              .first;
+      if (around != obstacle_iter.first && around > closest)
+        furthest = around;
+      else if (open_wall(player_pos))
+        continue;
+    } else if (planned != path.end() && planned > closest) {
+      const auto &tile = std::get<Tile>(*planned);
+      if (tile.Plane == player_pos.Plane &&
+          tile.DistanceFrom(player_pos) < line_of_sight_distance)
+        furthest = planned;
+    }
 
+    planned = path.end();
     if (furthest == path.end())
-      return false;
+      furthest = next_target(closest, player_pos);
+
+    if (furthest == path.end())
+      return finish(walk_status::no_target);
 
-    // std::cout << "Here 4\n";
-    // Wait(1000);
-    const auto reachable = [](const Tile &t) {
-      // Check local pathfinding.
-      return !Pathfinding::FindNodePathTo(t).empty();
+    const auto reachable = [&](const Tile &t) {
+      return reachability.reachable(player_pos, t);
     };
 
     if (auto tile = std::get_if<Tile>(&*furthest)) {
       if (!reachable(*tile)) {
+        // the path goes through a closed wall put into the overlay on a
+        // stall, and the player has walked up to it
+        const auto at_wall = std::any_of(
+            overlaid.begin(), overlaid.end(), [&](const auto &entry) {
+              return entry.wall.Plane == player_pos.Plane &&
+                     entry.wall.DistanceFrom(player_pos) <= 1;
+            });
+        if (at_wall && open_wall(player_pos))
+          continue;
+
         Debug::Info << "Not reachable, error\n";
         attempts++;
         if (attempts > 5)
-          return false;
+          return finish(walk_status::unreachable);
         continue;
       }
 
-      as::mouse_camera::set_pitch(360, 20, 15);
+      ++result.clicks;
+      if (!click_walk_tile(*tile, settings.mode))
+        continue;
 
-      if (!Mainscreen::IsTileOn(*tile)) {
-        if (!as::mouse_camera::rotate_to(*tile, 20))
-          continue;
-      }
+      const auto clicked_at = tick::player().position;
+      if (!tick::wait(settings.stall_ticks * tick::length.count(),
+                      []() { return tick::player().moving; })) {
+        // the click did not move the player, something is in the way
+        const auto &player = tick::player();
+        if (player.position == clicked_at && !player.animating &&
+            !on_stall(player.position))
+          return finish(walk_status::unreachable);
 
-      if (!Mainscreen::ClickTile(*tile))
         continue;
+      }
 
-      if (!WaitFunc(1000, 50, Mainscreen::IsMoving))
-        continue;
+      close_leg();
+      leg = walk_result::leg{*tile};
+      leg_started = clock::now();
+      leg_index = closest - path.begin();
+
+      // this leg ends at an obstacle, get it ready while walking
+      if (obstacle_iter.first != path.end() &&
+          obstacle_iter.second != prepared &&
+          obstacle_iter.second->first.DistanceFrom(*tile) <= 3) {
+        prepared = obstacle_iter.second;
+        prepared->second->prepare();
+      }
 
       const auto dest = Minimap::GetDestination();
       if (!dest)
         continue;
 
-      WaitFunc(10000, 50, [&]() {
-        if (Players::GetLocal().GetTile().DistanceFrom(dest) <= distance) {
-          Wait(UniformRandom(100, 400));
+      bool stalled = false;
+      stall.reset();
+
+      if (!settings.pipelined) {
+        tick::wait(10000, [&]() {
+          if (stall.update(tick::player())) {
+            stalled = true;
+            return true;
+          }
+
+          if (tick::player().position.DistanceFrom(dest) <= settings.distance) {
+            Wait(UniformRandom(100, 400));
+            return true;
+          }
+
+          return false;
+        });
+
+        if (stalled && !on_stall(tick::player().position))
+          return finish(walk_status::unreachable);
+
+        continue;
+      }
+
+      // work out the next click from the tile being walked to, and when it
+      // will be clicked on the mainscreen turn the camera to it while walking
+      auto next = next_target(furthest, *tile);
+      if (next != path.end() && next > furthest) {
+        if (auto next_tile = std::get_if<Tile>(&*next)) {
+          planned = next;
+          if (settings.mode == walk_mode::mainscreen &&
+              !Mainscreen::IsTileOn(*next_tile))
+            as::mouse_camera::rotate_to(*next_tile, 20);
+        }
+      }
+
+      // click again once the predicted arrival is within the margin, or when
+      // the player stops early
+      const auto model = movement_model::current();
+      tick::wait(10000, [&]() {
+        const auto &player = tick::player();
+        if (stall.update(player)) {
+          stalled = true;
           return true;
         }
 
-        return false;
+        if (!player.moving)
+          return true;
+
+        if (cursor.update(player.position, 10) == path.end())
+          return true;
+
+        // paths only step north, east, south and west, but the player walks
+        // diagonals, so what is left is the Chebyshev distance, not steps
+        const auto left = std::max(std::abs(tile->X - player.position.X),
+                                   std::abs(tile->Y - player.position.Y));
+        return model.eta(left) <= settings.margin;
       });
+
+      if (stalled && !on_stall(tick::player().position))
+        return finish(walk_status::unreachable);
     } else {
       Debug::Info << "Furthest is not a tile\n";
       Wait(100);
     }
   }
-  return true;
+}
+
+walk_result walk_path(const path &path, const walk_settings &settings) {
+  return walk_path(path, settings, []() { return false; });
+}
+
+// The entry points from before walk_result, true when the walk arrived or was
+// stopped. Pass walk_settings for the result.
+bool walk_path(const path &path, std::int32_t distance, const auto predicate) {
+  walk_settings settings;
+  settings.distance = distance;
+  return static_cast<bool>(walk_path(path, settings, predicate));
 }
 
 bool walk_path(const path &path, std::int32_t distance = 4) {
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "collision.hpp"
+#include "local_reachability.hpp"
+#include "obstacles.hpp"
+#include "path.hpp"
+#include "path_finder_settings.hpp"
+#include "tile_key.hpp"
+
+namespace as::web_walker {
+// Precomputed routes, keyed by the area the walk starts in, the area of the
+// destination and the path finder settings, so trips to any tile of a bank or
+// an altar share one route. The route ends on the tile it was stored for,
+// find_path finishes it to the exact destination with a short search. Routes
+// are stored with the collision data version they were found with and are
+// ignored once it changes. Obstacles are stored by their stable obstacle_id.
+// At most capacity routes are kept, the least recently used one is dropped
+// first. All members lock, so the library can be shared by threads searching
+// with their own search_context.
+class route_library {
+public:
+  // side length of the square start and destination areas that share one
+  // route
+  static constexpr std::int32_t area_size = 8;
+
+  static constexpr std::size_t default_capacity = 1024;
+
+  class key {
+  public:
+    std::uint32_t start_area;
+    std::uint32_t dest_area;
+    std::uint64_t settings_hash;
+
+    key(const Tile &start, const Tile &dest,
+        const path_finder_settings &settings)
+        : start_area(area_of(start)), dest_area(area_of(dest)),
+          settings_hash(settings.hash()) {}
+
+    key(std::uint32_t start_area, std::uint32_t dest_area,
+        std::uint64_t settings_hash)
+        : start_area(start_area), dest_area(dest_area),
+          settings_hash(settings_hash) {}
+
+    bool operator==(const key &other) const {
+      return start_area == other.start_area && dest_area == other.dest_area &&
+             settings_hash == other.settings_hash;
+    }
+
+    static std::uint32_t area_of(const Tile &tile) {
+      return tile_key(Tile(tile.X / area_size, tile.Y / area_size, tile.Plane))
+          .value;
+    }
+  };
+
+  class key_hash {
+  public:
+    std::size_t operator()(const key &k) const {
+      const auto areas = (static_cast<std::uint64_t>(k.start_area) << 32) |
+                         k.dest_area;
+
+      return detail::mix(k.settings_hash ^ detail::mix(areas));
+    }
+  };
+
+  explicit route_library(std::size_t capacity = default_capacity)
+      : _capacity(std::max(capacity, std::size_t(1))) {}
+
+  // The stored route from start's area to dest's area, from start on if
+  // start lies on it. It ends where the stored trip ended, not on dest. A route that neither passes start nor starts on a tile locally
+  // reachable from it was found from the other side of a wall, and is a
+  // miss.
+  std::optional<path> find(const Tile &start, const Tile &dest,
+                           const path_finder_settings &settings) {
+    std::lock_guard lock(_mutex);
+
+    auto it = _routes.find(key(start, dest, settings));
+    if (it == _routes.end())
+      return std::nullopt;
+
+    auto &e = it->second->second;
+    if (e.collision_version != collision_version) {
+      _erase(it);
+      return std::nullopt;
+    }
+
+    auto first = std::find_if(e.steps.begin(), e.steps.end(),
+                              [&](const stored_step &step) {
+                                return !step.is_obstacle && step.tile == start;
+                              });
+    if (first == e.steps.end()) {
+      first = e.steps.begin();
+      if (first == e.steps.end() || first->is_obstacle ||
+          !local_reachability::local().reachable(start, first->tile))
+        return std::nullopt;
+    }
+
+    if ((!e.resolved || e.obstacle_version != obstacle_version) &&
+        !_resolve(e)) {
+      _erase(it);
+      return std::nullopt;
+    }
+
+    _lru.splice(_lru.begin(), _lru, it->second);
+
+    path::vector result;
+    result.reserve(static_cast<std::size_t>(e.steps.end() - first));
+    for (; first != e.steps.end(); ++first) {
+      if (first->is_obstacle)
+        result.emplace_back(path::obstacle_step(first->tile, first->handler));
+      else
+        result.emplace_back(first->tile);
+    }
+
+    return path(std::move(result));
+  }
+
+  // Stores the route, unless it uses teleports which have no stable id.
+  bool store(const Tile &start, const Tile &dest,
+             const path_finder_settings &settings, const path &p) {
+    if (!p.teleport_positions().empty())
+      return false;
+
+    entry e;
+    e.collision_version = collision_version;
+    e.obstacle_version = obstacle_version;
+    e.resolved = true;
+    e.steps.reserve(p.size());
+    for (const auto &value : p) {
+      if (auto tile = std::get_if<Tile>(&value)) {
+        e.steps.push_back(stored_step{*tile, false, 0, nullptr});
+      } else if (auto obs = std::get_if<path::obstacle_step>(&value)) {
+        e.steps.push_back(
+            stored_step{obs->first, true,
+                        obstacle_id(obs->first, *obs->second), obs->second});
+      }
+    }
+
+    std::lock_guard lock(_mutex);
+    _insert(key(start, dest, settings), std::move(e));
+    return true;
+  }
+
+  void clear() {
+    std::lock_guard lock(_mutex);
+    _routes.clear();
+    _lru.clear();
+  }
+
+  std::size_t size() const {
+    std::lock_guard lock(_mutex);
+    return _routes.size();
+  }
+
+  std::size_t capacity() const { return _capacity; }
+
+  void load(const std::filesystem::path &file) {
+    std::lock_guard lock(_mutex);
+
+    auto ifs = std::ifstream(file, std::ios::in | std::ios::binary);
+    if (!ifs) {
+      throw std::runtime_error("failed to open " + file.string());
+    }
+
+    if (_read<std::uint32_t>(ifs) != magic ||
+        _read<std::uint32_t>(ifs) != format_version) {
+      throw std::runtime_error("unsupported route library " + file.string());
+    }
+
+    const auto size = std::filesystem::file_size(file);
+
+    const auto count = _read<std::uint32_t>(ifs);
+    for (std::uint32_t i = 0; i < count && ifs; ++i) {
+      const auto start_area = _read<std::uint32_t>(ifs);
+      const auto dest_area = _read<std::uint32_t>(ifs);
+      const auto settings_hash = _read<std::uint64_t>(ifs);
+
+      entry e;
+      e.collision_version = _read<std::uint64_t>(ifs);
+
+      // a corrupt count must not allocate more than the file could hold
+      const auto steps = _read<std::uint32_t>(ifs);
+      const auto position = ifs.tellg();
+      if (!ifs || position < 0 ||
+          steps > (size - static_cast<std::uintmax_t>(position)) /
+                      stored_step_size) {
+        throw std::runtime_error("truncated route library " + file.string());
+      }
+
+      e.steps.reserve(steps);
+      for (std::uint32_t j = 0; j < steps && ifs; ++j) {
+        const auto tile = _read_tile(ifs);
+        const auto is_obstacle = _read<std::uint8_t>(ifs) != 0;
+        e.steps.push_back(stored_step{tile, is_obstacle,
+                                      _read<std::uint32_t>(ifs), nullptr});
+      }
+
+      _insert(key(start_area, dest_area, settings_hash), std::move(e));
+    }
+
+    if (!ifs) {
+      throw std::runtime_error("truncated route library " + file.string());
+    }
+  }
+
+  void save(const std::filesystem::path &file) const {
+    std::lock_guard lock(_mutex);
+
+    auto ofs = std::ofstream(file, std::ios::out | std::ios::binary);
+    if (!ofs) {
+      throw std::runtime_error("failed to open " + file.string());
+    }
+
+    _write(ofs, magic);
+    _write(ofs, format_version);
+    _write(ofs, static_cast<std::uint32_t>(_routes.size()));
+
+    // least recently used first, so loading keeps the order
+    for (auto it = _lru.rbegin(); it != _lru.rend(); ++it) {
+      const auto &[k, e] = *it;
+      _write(ofs, k.start_area);
+      _write(ofs, k.dest_area);
+      _write(ofs, k.settings_hash);
+      _write(ofs, e.collision_version);
+      _write(ofs, static_cast<std::uint32_t>(e.steps.size()));
+
+      for (const auto &step : e.steps) {
+        _write_tile(ofs, step.tile);
+        _write(ofs, static_cast<std::uint8_t>(step.is_obstacle));
+        _write(ofs, step.obstacle);
+      }
+    }
+  }
+
+private:
+  static constexpr std::uint32_t magic = 0x4c525341; // "ASRL"
+  // Bumped whenever the layout, the area encoding or the obstacle_id encoding
+  // changes, as old files would load under the wrong keys. Version 2 packs
+  // both with tile_key, version 3 keys by the destination area.
+  static constexpr std::uint32_t format_version = 3;
+
+  // bytes of one step in a file: the tile, the obstacle flag and its id
+  static constexpr std::uintmax_t stored_step_size =
+      3 * sizeof(std::int32_t) + sizeof(std::uint8_t) + sizeof(std::uint32_t);
+
+  class stored_step {
+  public:
+    Tile tile;
+    bool is_obstacle;
+    std::uint32_t obstacle;
+    const web_walker::obstacle *handler;
+  };
+
+  class entry {
+  public:
+    std::uint64_t collision_version = 0;
+    std::uint64_t obstacle_version = 0;
+    bool resolved = false; // handlers point into obstacle_map
+    std::vector<stored_step> steps;
+  };
+
+  using lru_list = std::list<std::pair<key, entry>>;
+
+  mutable std::mutex _mutex;
+  std::size_t _capacity;
+  lru_list _lru; // most recently used first
+  std::unordered_map<key, lru_list::iterator, key_hash> _routes;
+
+  // obstacle_map by obstacle_id, as of _indexed_version
+  std::unordered_map<std::uint32_t, const web_walker::obstacle *> _obstacles;
+  std::uint64_t _indexed_version = 0;
+  bool _indexed = false;
+
+  using route_map = decltype(_routes);
+
+  void _insert(const key &k, entry &&e) {
+    if (auto it = _routes.find(k); it != _routes.end())
+      _erase(it);
+
+    _lru.emplace_front(k, std::move(e));
+    _routes.emplace(k, _lru.begin());
+
+    while (_routes.size() > _capacity) {
+      _routes.erase(_lru.back().first);
+      _lru.pop_back();
+    }
+  }
+
+  void _erase(route_map::iterator it) {
+    _lru.erase(it->second);
+    _routes.erase(it);
+  }
+
+  // points the obstacle steps at the current obstacle_map
+  bool _resolve(entry &e) {
+    if (!_indexed || _indexed_version != obstacle_version) {
+      _obstacles.clear();
+      for (const auto &[tile, obs] : obstacle_map)
+        _obstacles.emplace(obstacle_id(tile, *obs), obs.get());
+
+      _indexed_version = obstacle_version;
+      _indexed = true;
+    }
+
+    for (auto &step : e.steps) {
+      if (!step.is_obstacle)
+        continue;
+
+      auto it = _obstacles.find(step.obstacle);
+      if (it == _obstacles.end())
+        return false;
+
+      step.handler = it->second;
+    }
+
+    e.obstacle_version = obstacle_version;
+    e.resolved = true;
+    return true;
+  }
+
+  template <typename T> static T _read(std::istream &is) {
+    T value{};
+    is.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return value;
+  }
+
+  template <typename T> static void _write(std::ostream &os, const T &value) {
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  static Tile _read_tile(std::istream &is) {
+    const auto x = _read<std::int32_t>(is);
+    const auto y = _read<std::int32_t>(is);
+    const auto plane = _read<std::int32_t>(is);
+    return Tile(x, y, plane);
+  }
+
+  static void _write_tile(std::ostream &os, const Tile &tile) {
+    _write(os, tile.X);
+    _write(os, tile.Y);
+    _write(os, tile.Plane);
+  }
+};
+
+route_library routes;
+} // namespace as::web_walker
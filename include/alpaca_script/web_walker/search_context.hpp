@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+#include "bucket_queue.hpp"
+#include "path.hpp"
+#include "tile_key.hpp"
+
+namespace as::web_walker {
+// Scratch space of a path search: the frontier, the node arena, the best cost
+// per tile and the output buffer. Everything keeps its capacity across
+// searches, so once warmed up a search only allocates the steps of the path it
+// returns, and its obstacle and teleport index if it has any. A route served
+// by the route library skips the search and allocates its own copy instead.
+// All of it, and the paths its searches return, come from the context's
+// memory_resource.
+class search_context {
+public:
+  static constexpr std::uint32_t no_parent =
+      std::numeric_limits<std::uint32_t>::max();
+
+  class node {
+  public:
+    path::value_type value;
+    std::uint32_t parent;
+  };
+
+  // Costs keyed by tile_key in a flat open-addressing table. Entries belong to
+  // the search that wrote them, so clearing is one increment of the stamp.
+  class cost_map {
+  public:
+    explicit cost_map(
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : _slots(1024, resource) {}
+
+    // cost of the tile in this search, or nullptr
+    const std::uint32_t *find(const tile_key &key) const {
+      const auto mask = _slots.size() - 1;
+      for (auto i = _index(key); _slots[i].stamp == _stamp;
+           i = (i + 1) & mask) {
+        if (_slots[i].key == key.value)
+          return &_slots[i].cost;
+      }
+
+      return nullptr;
+    }
+
+    // lowers the cost of the tile, returns false if it was already as cheap
+    bool lower(const tile_key &key, std::uint32_t cost) {
+      if ((_size + 1) * 2 > _slots.size())
+        _grow();
+
+      const auto mask = _slots.size() - 1;
+      auto i = _index(key);
+      for (; _slots[i].stamp == _stamp; i = (i + 1) & mask) {
+        if (_slots[i].key != key.value)
+          continue;
+
+        if (_slots[i].cost <= cost)
+          return false;
+
+        _slots[i].cost = cost;
+        return true;
+      }
+
+      _slots[i] = slot{key.value, _stamp, cost};
+      ++_size;
+      return true;
+    }
+
+    void clear() {
+      _size = 0;
+      if (++_stamp == 0) {
+        // the stamp wrapped around, forget every old entry for real
+        std::fill(_slots.begin(), _slots.end(), slot{});
+        _stamp = 1;
+      }
+    }
+
+    std::size_t size() const { return _size; }
+
+  private:
+    class slot {
+    public:
+      std::uint32_t key = 0;
+      std::uint32_t stamp = 0;
+      std::uint32_t cost = 0;
+    };
+
+    std::pmr::vector<slot> _slots;
+    std::uint32_t _stamp = 1;
+    std::size_t _size = 0;
+
+    std::size_t _index(const tile_key &key) const {
+      return std::hash<tile_key>{}(key) & (_slots.size() - 1);
+    }
+
+    void _grow() {
+      auto old = std::move(_slots);
+      _slots.assign(old.size() * 2, slot{});
+
+      const auto mask = _slots.size() - 1;
+      for (const auto &s : old) {
+        if (s.stamp != _stamp)
+          continue;
+
+        auto i = _index(tile_key(s.key));
+        while (_slots[i].stamp == _stamp)
+          i = (i + 1) & mask;
+
+        _slots[i] = s;
+      }
+    }
+  };
+
+  bucket_queue<std::uint32_t> frontier; // indices into nodes
+  std::pmr::vector<node> nodes;
+  cost_map costs;
+  path::vector steps;
+
+  explicit search_context(
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : frontier(resource), nodes(resource), costs(resource), steps(resource) {}
+
+  std::pmr::memory_resource *resource() const {
+    return nodes.get_allocator().resource();
+  }
+
+  void clear() {
+    frontier.clear();
+    nodes.clear();
+    costs.clear();
+    steps.clear();
+  }
+
+  std::uint32_t add_node(const path::value_type &value, std::uint32_t parent) {
+    nodes.push_back(node{value, parent});
+    return static_cast<std::uint32_t>(nodes.size() - 1);
+  }
+
+  // Steps from the root to the given node, in the reused output buffer.
+  const path::vector &trace(std::uint32_t index) {
+    steps.clear();
+    for (; index != no_parent; index = nodes[index].parent)
+      steps.push_back(nodes[index].value);
+
+    std::reverse(steps.begin(), steps.end());
+    return steps;
+  }
+
+  // context used by searches that are not given one
+  static search_context &local() {
+    thread_local search_context context;
+    return context;
+  }
+};
+} // namespace as::web_walker
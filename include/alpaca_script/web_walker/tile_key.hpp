@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Core/Types/Tile.hpp>
+#include <cstdint>
+#include <functional>
+
+namespace as::web_walker {
+// Canonical packed form of a tile used as the key of every web walker
+// container: the plane in the top 2 bits, then 15 bits each of x and y.
+class tile_key {
+public:
+  std::uint32_t value = 0;
+
+  tile_key() = default;
+
+  explicit tile_key(std::uint32_t value) : value(value) {}
+
+  tile_key(const Tile &tile)
+      : value((static_cast<std::uint32_t>(tile.Plane & 0x3) << 30) |
+              (static_cast<std::uint32_t>(tile.X & 0x7fff) << 15) |
+              static_cast<std::uint32_t>(tile.Y & 0x7fff)) {}
+
+  std::int32_t x() const {
+    return static_cast<std::int32_t>((value >> 15) & 0x7fff);
+  }
+
+  std::int32_t y() const { return static_cast<std::int32_t>(value & 0x7fff); }
+
+  std::int32_t plane() const {
+    return static_cast<std::int32_t>(value >> 30);
+  }
+
+  Tile to_tile() const { return Tile(x(), y(), plane()); }
+
+  bool operator==(const tile_key &other) const { return value == other.value; }
+
+  bool operator!=(const tile_key &other) const { return value != other.value; }
+
+  bool operator<(const tile_key &other) const { return value < other.value; }
+};
+} // namespace as::web_walker
+
+// murmur3 finalizer, so neighbouring tiles and planes spread over all buckets
+template <> struct std::hash<as::web_walker::tile_key> {
+  std::size_t operator()(const as::web_walker::tile_key &key) const {
+    auto h = key.value;
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+  }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Core/Types/Tile.hpp>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "obstacle.hpp"
+
+namespace as::web_walker {
+// why walk_path returned
+enum class walk_status {
+  arrived,         // within the walk distance of the end of the path
+  stopped,         // the caller's predicate asked to stop
+  logged_out,      // not logged in
+  off_path,        // the player is no longer near the path
+  no_target,       // no tile of the path to click
+  unreachable,     // the tiles to click were not reachable too many times
+  obstacle_failed, // an obstacle could not be passed too many times
+};
+
+// What a walk_path call did, for finding the routes and obstacles that slow
+// walking down.
+class walk_result {
+public:
+  using duration = std::chrono::milliseconds;
+
+  // from one click on the path to the next
+  class leg {
+  public:
+    Tile target;
+    duration time{0};
+    std::int32_t tiles = 0; // path steps walked
+  };
+
+  class obstacle_pass {
+  public:
+    Tile tile;
+    Tile destination;
+    obstacle_kind kind = obstacle_kind::custom;
+    duration time{0};
+    bool passed = false;
+  };
+
+  walk_status status = walk_status::arrived;
+
+  std::vector<leg> legs;
+  std::vector<obstacle_pass> obstacles;
+
+  std::int32_t clicks = 0;           // clicks on the path, including misses
+  std::int32_t obstacle_retries = 0; // failed obstacle handles
+  std::int32_t stalls = 0;           // times the player got stuck
+  std::int32_t tiles = 0;            // path steps walked in total
+  duration time{0};
+
+  // distance from the player to the end of the path when the walk ended
+  std::int32_t final_distance = -1;
+
+  double tiles_per_second() const {
+    return time.count() > 0 ? tiles * 1000.0 / time.count() : 0.0;
+  }
+
+  explicit operator bool() const {
+    return status == walk_status::arrived || status == walk_status::stopped;
+  }
+};
+} // namespace as::web_walker
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Game/Core.hpp>
+#include <alpaca_script/tick.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "walk_result.hpp"
+
+namespace as::web_walker {
+// how walk_path clicks the tiles it walks to, obstacles are always handled on
+// the mainscreen
+enum class walk_mode {
+  // the mainscreen if the tile is on it, the minimap if the tile is on that,
+  // and the mainscreen after turning the camera otherwise
+  automatic,
+  // the minimap whenever the tile is on it
+  minimap,
+  // the mainscreen, turning the camera as needed
+  mainscreen,
+};
+
+class walk_settings {
+public:
+  // the walk is done once the player is this close to the end of the path
+  std::int32_t distance = 4;
+
+  walk_mode mode = walk_mode::automatic;
+
+  // click the next tile before the player arrives at the last one, so the
+  // player never stops moving
+  bool pipelined = false;
+
+  // how long before the predicted arrival the next click is made
+  std::chrono::milliseconds margin = tick::length;
+
+  // the player is stuck after standing still this many ticks while not
+  // animating
+  std::int32_t stall_ticks = 2;
+
+  // called with the result of every walk
+  std::function<void(const walk_result &)> sink;
+
+  walk_settings() = default;
+};
+
+// How far the player moves per game tick, used to predict arrivals.
+class movement_model {
+public:
+  bool running = false;
+
+  static movement_model current() {
+    return movement_model{Minimap::IsRunEnabled()};
+  }
+
+  std::int32_t tiles_per_tick() const { return running ? 2 : 1; }
+
+  // game ticks to walk the given number of tiles in a straight or diagonal
+  // line
+  std::int32_t ticks(std::int32_t tiles) const {
+    return (tiles + tiles_per_tick() - 1) / tiles_per_tick();
+  }
+
+  std::chrono::milliseconds eta(std::int32_t tiles) const {
+    return ticks(tiles) * tick::length;
+  }
+};
+
+// Notices the player standing still for a number of ticks while not
+// animating, from the shared player samples.
+class stall_detector {
+public:
+  std::int32_t ticks;
+
+  explicit stall_detector(std::int32_t ticks) : ticks(ticks) {}
+
+  bool update(const tick::player_state &player) {
+    if (_since == tick::clock_type::time_point() ||
+        player.position != _position || player.animating) {
+      _position = player.position;
+      _since = player.time;
+      return false;
+    }
+
+    return player.time - _since >= ticks * tick::length;
+  }
+
+  void reset() { _since = tick::clock_type::time_point(); }
+
+private:
+  Tile _position;
+  tick::clock_type::time_point _since;
+};
+} // namespace as::web_walker
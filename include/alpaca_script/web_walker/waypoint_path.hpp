@@ -0,0 +1,390 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "path.hpp"
+
+namespace as::web_walker {
+// Compact form of a path: only the tiles where the direction changes are
+// stored, together with every obstacle and teleport step. The tiles in between
+// two corners are expanded on demand.
+class waypoint_path {
+public:
+  using obstacle_step = path::obstacle_step;
+
+  using teleport_step = path::teleport_step;
+
+  using value_type = path::value_type;
+
+  class waypoint {
+  public:
+    value_type value;
+
+    // position of this step in the expanded path
+    std::size_t index;
+
+    waypoint(const value_type &value, std::size_t index)
+        : value(value), index(index) {}
+  };
+
+  using vector = std::vector<waypoint>;
+
+  class iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = waypoint_path::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    iterator() = default;
+
+    iterator(const waypoint_path *owner, std::size_t position)
+        : _owner(owner), _position(position) {
+      _load();
+    }
+
+    reference operator*() const { return _value; }
+
+    pointer operator->() const { return &_value; }
+
+    iterator &operator++() {
+      ++_position;
+      _load();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    iterator &operator--() {
+      --_position;
+      _load();
+      return *this;
+    }
+
+    iterator operator--(int) {
+      auto result = *this;
+      --*this;
+      return result;
+    }
+
+    bool operator==(const iterator &other) const {
+      return _position == other._position;
+    }
+
+    bool operator!=(const iterator &other) const { return !(*this == other); }
+
+    std::size_t index() const { return _position; }
+
+  private:
+    const waypoint_path *_owner = nullptr;
+    std::size_t _position = 0;
+    value_type _value;
+
+    void _load() {
+      if (_owner && _position < _owner->size())
+        _value = _owner->at(_position);
+    }
+  };
+
+  using const_iterator = iterator;
+
+  vector waypoints;
+
+  waypoint_path() = default;
+
+  waypoint_path(const waypoint_path &other)
+      : waypoints(other.waypoints), _size(other._size) {}
+
+  waypoint_path(waypoint_path &&other)
+      : waypoints(std::move(other.waypoints)), _size(other._size) {}
+
+  waypoint_path(const path &p) {
+    const auto &steps = p.steps();
+    _size = steps.size();
+
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+      if (i == 0 || i + 1 == steps.size() ||
+          !_interior(steps[i - 1], steps[i], steps[i + 1])) {
+        waypoints.emplace_back(steps[i], i);
+      }
+    }
+  }
+
+  waypoint_path &operator=(const waypoint_path &other) {
+    waypoints = other.waypoints;
+    _size = other._size;
+    return *this;
+  }
+
+  waypoint_path &operator=(waypoint_path &&other) {
+    waypoints = std::move(other.waypoints);
+    _size = other._size;
+    return *this;
+  }
+
+  // number of steps in the expanded path
+  std::size_t size() const { return _size; }
+
+  bool empty() const { return _size == 0; }
+
+  value_type at(std::size_t position) const {
+    auto it = _waypoint_at(position);
+    if (it->index == position)
+      return it->value;
+
+    const auto &from = std::get<Tile>(it->value);
+    const auto &to = std::get<Tile>(std::next(it)->value);
+    return _offset(from, _step(from, to, std::next(it)->index - it->index),
+                   position - it->index);
+  }
+
+  path expand() const {
+    path::vector steps;
+    steps.reserve(_size);
+    for (auto it = begin(); it != end(); ++it)
+      steps.emplace_back(*it);
+
+    return path(std::move(steps));
+  }
+
+  iterator begin() const { return iterator(this, 0); }
+
+  iterator end() const { return iterator(this, _size); }
+
+  const value_type &front() const { return waypoints.front().value; }
+
+  const value_type &back() const { return waypoints.back().value; }
+
+  iterator closest(
+      iterator it, iterator end, const Tile &tile,
+      std::int32_t distance = std::numeric_limits<std::int32_t>::max()) const {
+    const auto first = it.index();
+    const auto last = end.index();
+    auto closest = last;
+
+    _visit_runs(first, last, tile, [&](const Tile &from, const Tile &step,
+                                       std::size_t index, std::size_t t0,
+                                       std::size_t t1) {
+      const auto dist_at = [&](std::size_t t) {
+        return _offset(from, step, t).DistanceFrom(tile);
+      };
+
+      // distance along a straight run is unimodal, so the closest tile is
+      // next to the projection and the first tie is found by bisection
+      auto best = _project(from, step, tile, t0, t1);
+      for (auto t : {best - (best > t0 ? 1 : 0), best + (best < t1 ? 1 : 0)}) {
+        if (dist_at(t) < dist_at(best))
+          best = t;
+      }
+
+      const auto best_dist = dist_at(best);
+      if (best_dist >= distance)
+        return false;
+
+      auto lo = t0, hi = best;
+      while (lo < hi) {
+        const auto mid = lo + (hi - lo) / 2;
+        if (dist_at(mid) <= best_dist)
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+
+      closest = index + lo;
+      distance = best_dist;
+      return false;
+    });
+
+    return iterator(this, closest);
+  }
+
+  iterator closest(
+      const Tile &tile,
+      std::int32_t distance = std::numeric_limits<std::int32_t>::max()) const {
+    return closest(begin(), end(), tile, distance);
+  }
+
+  iterator furthest(
+      iterator it, iterator end, const Tile &tile,
+      std::int32_t distance = std::numeric_limits<std::int32_t>::min()) const {
+    const auto first = it.index();
+    const auto last = end.index();
+    auto furthest = last;
+
+    // return furthest tile within the given distance
+    _visit_runs_reverse(first, last, tile, [&](const Tile &from,
+                                               const Tile &step,
+                                               std::size_t index,
+                                               std::size_t t0, std::size_t t1) {
+      const auto dist_at = [&](std::size_t t) {
+        return _offset(from, step, t).DistanceFrom(tile);
+      };
+
+      auto nearest = _project(from, step, tile, t0, t1);
+      for (auto t : {nearest - (nearest > t0 ? 1 : 0),
+                     nearest + (nearest < t1 ? 1 : 0)}) {
+        if (dist_at(t) < dist_at(nearest))
+          nearest = t;
+      }
+
+      if (dist_at(nearest) >= distance)
+        return false;
+
+      auto lo = nearest, hi = t1;
+      while (lo < hi) {
+        const auto mid = hi - (hi - lo) / 2;
+        if (dist_at(mid) < distance)
+          lo = mid;
+        else
+          hi = mid - 1;
+      }
+
+      furthest = index + lo;
+      return true;
+    });
+
+    return iterator(this, furthest);
+  }
+
+  iterator furthest(
+      const Tile &tile,
+      std::int32_t distance = std::numeric_limits<std::int32_t>::min()) const {
+    return furthest(begin(), end(), tile, distance);
+  }
+
+  std::pair<iterator, const obstacle_step *> next_obstacle(iterator it,
+                                                           iterator end) const {
+    auto wp = std::lower_bound(
+        waypoints.begin(), waypoints.end(), it.index(),
+        [](const waypoint &w, std::size_t index) { return w.index < index; });
+
+    for (; wp != waypoints.end() && wp->index < end.index(); ++wp) {
+      if (auto step = std::get_if<obstacle_step>(&wp->value))
+        return {iterator(this, wp->index), step};
+    }
+
+    return {end, nullptr};
+  }
+
+  std::pair<iterator, const obstacle_step *> next_obstacle() const {
+    return next_obstacle(begin(), end());
+  }
+
+private:
+  std::size_t _size = 0;
+
+  static bool _unit_step(const Tile &from, const Tile &to) {
+    const auto dx = to.X - from.X;
+    const auto dy = to.Y - from.Y;
+    return from.Plane == to.Plane && (dx != 0 || dy != 0) && dx >= -1 &&
+           dx <= 1 && dy >= -1 && dy <= 1;
+  }
+
+  static bool _interior(const value_type &prev, const value_type &current,
+                        const value_type &next) {
+    auto a = std::get_if<Tile>(&prev);
+    auto b = std::get_if<Tile>(&current);
+    auto c = std::get_if<Tile>(&next);
+    if (!a || !b || !c)
+      return false;
+
+    return _unit_step(*a, *b) && b->Plane == c->Plane &&
+           b->X - a->X == c->X - b->X && b->Y - a->Y == c->Y - b->Y;
+  }
+
+  static Tile _offset(const Tile &from, const Tile &step, std::size_t t) {
+    const auto n = static_cast<std::int32_t>(t);
+    return Tile(from.X + step.X * n, from.Y + step.Y * n, from.Plane);
+  }
+
+  static Tile _step(const Tile &from, const Tile &to, std::size_t count) {
+    const auto n = static_cast<std::int32_t>(count);
+    return Tile((to.X - from.X) / n, (to.Y - from.Y) / n, 0);
+  }
+
+  // offset in [t0, t1] along a run that is nearest to tile
+  static std::size_t _project(const Tile &from, const Tile &step,
+                              const Tile &tile, std::size_t t0,
+                              std::size_t t1) {
+    const auto len = step.X * step.X + step.Y * step.Y;
+    if (len == 0)
+      return t0;
+
+    const auto dot = (tile.X - from.X) * step.X + (tile.Y - from.Y) * step.Y;
+    const auto t = std::clamp<std::int64_t>((2 * dot + len) / (2 * len),
+                                            static_cast<std::int64_t>(t0),
+                                            static_cast<std::int64_t>(t1));
+    return static_cast<std::size_t>(t);
+  }
+
+  vector::const_iterator _waypoint_at(std::size_t position) const {
+    auto it = std::upper_bound(
+        waypoints.begin(), waypoints.end(), position,
+        [](std::size_t index, const waypoint &w) { return index < w.index; });
+    return std::prev(it);
+  }
+
+  // calls func(from, step, index, t0, t1) for every straight run of tiles on
+  // the plane of tile, clipped to [first, last); the tiles of a run are
+  // from + step * t at position index + t for t in [t0, t1]
+  template <typename Func>
+  void _visit_run(vector::const_iterator wp, std::size_t first,
+                  std::size_t last, const Tile &tile, Func &&func,
+                  bool &stop) const {
+    auto from = std::get_if<Tile>(&wp->value);
+    if (!from || from->Plane != tile.Plane)
+      return;
+
+    auto next = std::next(wp);
+    auto count = std::size_t(1);
+    auto step = Tile(0, 0, 0);
+    if (next != waypoints.end() && next->index - wp->index > 1) {
+      count = next->index - wp->index;
+      step = _step(*from, std::get<Tile>(next->value), count);
+    }
+
+    const auto begin = std::max(wp->index, first);
+    const auto end = std::min(wp->index + count, last);
+    if (begin >= end)
+      return;
+
+    stop = func(*from, step, wp->index, begin - wp->index,
+                end - 1 - wp->index);
+  }
+
+  template <typename Func>
+  void _visit_runs(std::size_t first, std::size_t last, const Tile &tile,
+                   Func &&func) const {
+    if (first >= last)
+      return;
+
+    bool stop = false;
+    for (auto wp = _waypoint_at(first);
+         wp != waypoints.end() && wp->index < last && !stop; ++wp) {
+      _visit_run(wp, first, last, tile, func, stop);
+    }
+  }
+
+  template <typename Func>
+  void _visit_runs_reverse(std::size_t first, std::size_t last,
+                           const Tile &tile, Func &&func) const {
+    if (first >= last)
+      return;
+
+    bool stop = false;
+    const auto lowest = _waypoint_at(first);
+    for (auto wp = std::next(_waypoint_at(last - 1)); wp != lowest && !stop;) {
+      --wp;
+      _visit_run(wp, first, last, tile, func, stop);
+    }
+  }
+};
+} // namespace as::web_walker
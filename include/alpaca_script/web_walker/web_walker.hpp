@@ -1,11 +1,26 @@
 #pragma once
 
 #include "bank.hpp"
+#include "bank_distances.hpp"
 #include "banks/banks.hpp"
+#include "bucket_queue.hpp"
 #include "collision.hpp"
+#include "line_of_sight.hpp"
+#include "local_reachability.hpp"
 #include "obstacle.hpp"
+#include "obstacle_catalogue.hpp"
+#include "obstacle_edge.hpp"
+#include "obstacle_table.hpp"
+#include "obstacle_timings.hpp"
 #include "obstacles.hpp"
 #include "path_finding.hpp"
 #include "path.hpp"
+#include "path_cursor.hpp"
 #include "path_finder_settings.hpp"
-#include "teleport.hpp"
\ No newline at end of file
+#include "route_library.hpp"
+#include "search_context.hpp"
+#include "teleport.hpp"
+#include "tile_key.hpp"
+#include "walk_result.hpp"
+#include "walk_settings.hpp"
+#include "waypoint_path.hpp"
\ No newline at end of file